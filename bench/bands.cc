@@ -0,0 +1,127 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.hh"
+
+#include "app/window.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <random>
+#include <string>
+#include <thread>
+#include <memory>
+#include <iostream>
+#include <algorithm>
+
+// average time per frame of Window::encode over cur against prev, the
+// encoder starting from an unknown terminal state each frame, cells written
+// through data are not tracked as dirty so every cell is compared
+static void run(std::string const& name, Window& win, Buffer const& cur, Buffer& prev, std::size_t const frames) {
+  win.clear = false;
+  win.diff_full = true;
+  std::size_t bytes {0};
+  auto const ms = bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      win.enc.line.clear();
+      win.enc.cursor_valid = false;
+      win.enc.style = Style{};
+      win.encode(cur, prev);
+      bytes = win.enc.line.size();
+      keep(win.enc.line);
+    }
+  });
+  report(name, ms / static_cast<double>(frames), cur.size().x * cur.size().y, "cells");
+  std::cout << "  " << bytes << " bytes\n";
+}
+
+// bench_bands [threads], scaling up to threads, all cores by default
+int main(int argc, char** argv) {
+  Size const size {400, 120};
+  std::size_t const frames {50};
+  Style const base {Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("1b1e24"), OB::Prism::RGBA::hex("1b1e24")};
+  Style const bar {Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("df6c3e"), OB::Prism::RGBA::hex("1b1e24")};
+  std::size_t const cores = argc > 1 ? std::max(1ul, std::stoul(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+  std::cout << size.x << "x" << size.y << ", " << cores << " threads, time per frame\n";
+
+  Buffer prev {size, Cell{0, base, " "}};
+
+  // typical, a few percent of the cells changed
+  Buffer typical {prev};
+  std::mt19937 rng {7};
+  for (std::size_t i = 0; i < size.x * size.y / 32; ++i) {
+    typical.data()[rng() % (size.x * size.y)] = Cell{1, bar, "█"};
+  }
+
+  // worst case, every cell changed, alternating styles
+  Buffer worst {prev};
+  for (std::size_t i = 0; i < size.x * size.y; ++i) {
+    worst.data()[i] = Cell{1, i % 2 ? bar : base, "▄"};
+  }
+
+  for (auto const& [name, cur] : {std::make_pair("typical", &typical), std::make_pair("worst", &worst)}) {
+    // a single pass, what --threads=1 runs
+    {
+      Window win;
+      run(std::string{name} + " 1 thread", win, *cur, prev, frames);
+    }
+    // the same bands the pool splits the frame into, run in turn, the cost of
+    // restarting the cursor and style at every band
+    {
+      Window win;
+      win.pool = std::make_unique<OB::Pool>(1);
+      run(std::string{name} + " 1 thread bands", win, *cur, prev, frames);
+    }
+    for (std::size_t threads = 2; threads < cores * 2; threads *= 2) {
+      threads = std::min(threads, cores);
+      Window win;
+      win.pool = std::make_unique<OB::Pool>(threads);
+      run(std::string{name} + " " + std::to_string(threads) + " threads bands", win, *cur, prev, frames);
+    }
+  }
+
+  return 0;
+}
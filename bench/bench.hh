@@ -0,0 +1,88 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef BENCH_HH
+#define BENCH_HH
+
+#include <cstddef>
+
+#include <limits>
+#include <chrono>
+#include <string>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+// micro-benchmarks comparing a replaced implementation against the current
+// one, build in release mode for meaningful numbers
+
+// keep the compiler from dropping work whose result is unused
+template<typename T>
+inline void keep(T const& val) {
+  asm volatile("" : : "g"(&val) : "memory");
+}
+
+// best time of runs calls to fn, in milliseconds
+template<typename F>
+inline double bench(F&& fn, std::size_t const runs = 7) {
+  double best {std::numeric_limits<double>::max()};
+  for (std::size_t i = 0; i < runs; ++i) {
+    auto const begin = std::chrono::steady_clock::now();
+    fn();
+    best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+  }
+  return best;
+}
+
+// one result line, with a rate when count items were processed
+inline void report(std::string const& name, double const ms, std::size_t const count = 0, std::string const& unit = {}) {
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(3) << std::setw(10) << ms << "ms";
+  if (count) {
+    std::cout << std::setw(10) << std::setprecision(1) << (static_cast<double>(count) / ms / 1000.0) << "M " << unit << "/s";
+  }
+  std::cout << "\n";
+}
+
+#endif // BENCH_HH
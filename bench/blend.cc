@@ -0,0 +1,209 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.hh"
+
+#include "app/window.hh"
+#include "ob/prism.hh"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+
+using RGBA = OB::Prism::RGBA;
+
+// the compositing before it went through OB::Prism::blend, the source
+// colours prepared once and blended onto one cell at a time
+class Over_cell {
+public:
+  explicit Over_cell(Style const& src) : _fg {src.fg}, _bg {src.bg} {
+#if defined(__SSE2__)
+    std::uint16_t const fa {src.fg.a()};
+    std::uint16_t const ba {src.bg.a()};
+    _src = _mm_setr_epi16(
+      static_cast<short>(src.fg.r() * fa), static_cast<short>(src.fg.g() * fa), static_cast<short>(src.fg.b() * fa), 0,
+      static_cast<short>(src.bg.r() * ba), static_cast<short>(src.bg.g() * ba), static_cast<short>(src.bg.b() * ba), 0);
+    _inv = _mm_setr_epi16(
+      static_cast<short>(255 - fa), static_cast<short>(255 - fa), static_cast<short>(255 - fa), 0,
+      static_cast<short>(255 - ba), static_cast<short>(255 - ba), static_cast<short>(255 - ba), 0);
+#endif
+  }
+
+  void operator()(Style& dst) const {
+#if defined(__SSE2__)
+    if (((dst.fg.value() & dst.bg.value()) >> 24) == 255) {
+      auto const zero = _mm_setzero_si128();
+      auto const d = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, static_cast<int>(dst.bg.value()), static_cast<int>(dst.fg.value())), zero);
+      auto v = _mm_add_epi16(_mm_add_epi16(_src, _mm_mullo_epi16(d, _inv)), _mm_set1_epi16(128));
+      v = _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+      v = _mm_or_si128(_mm_packus_epi16(v, zero), _mm_set_epi32(0, 0, static_cast<int>(0xff000000), static_cast<int>(0xff000000)));
+      dst.fg.value(static_cast<std::uint32_t>(_mm_cvtsi128_si32(v)));
+      dst.bg.value(static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(v, 4))));
+      return;
+    }
+#endif
+    dst.fg += _fg;
+    dst.bg += _bg;
+  }
+
+private:
+  RGBA _fg;
+  RGBA _bg;
+#if defined(__SSE2__)
+  __m128i _src;
+  __m128i _inv;
+#endif
+}; // class Over_cell
+
+static void blend_cell(Cell& val, Cell const& cell, Over_cell const& over) {
+  if (cell.zidx < val.zidx) {return;}
+  over(val.style);
+  val.zidx = cell.zidx;
+  val.style.type = cell.style.type;
+  val.style.attr = cell.style.attr;
+  val.text = cell.text;
+}
+
+// the colours of every cell, to check both ways end up the same
+static bool same(Buffer const& lhs, std::vector<Cell> const& rhs) {
+  for (std::size_t i = 0; i < rhs.size(); ++i) {
+    if (lhs.data()[i].style.fg != rhs[i].style.fg || lhs.data()[i].style.bg != rhs[i].style.bg) {return false;}
+  }
+  return true;
+}
+
+int main() {
+  Size const size {300, 90};
+  std::size_t const frames {20};
+  auto const cells = size.x * size.y;
+  std::mt19937 rng {7};
+
+  // an opaque screen of varied colours
+  Buffer screen {size, Cell{0, Style{Style::Bit_24, 0, RGBA::hex("1b1e24"), RGBA::hex("1b1e24")}, " "}};
+  for (std::size_t i = 0; i < cells; ++i) {
+    auto const c = rng();
+    screen.data()[i].style.fg = RGBA(static_cast<std::uint8_t>(c), static_cast<std::uint8_t>(c >> 8), static_cast<std::uint8_t>(c >> 16), std::uint8_t{255});
+  }
+
+  // translucent bars of one colour each, filled down every column
+  std::vector<Cell> bars(size.x);
+  for (auto& e : bars) {
+    auto const c = rng();
+    e = Cell{1, Style{Style::Bit_24, 0, RGBA(static_cast<std::uint8_t>(c), static_cast<std::uint8_t>(c >> 8), static_cast<std::uint8_t>(c >> 16), static_cast<std::uint8_t>(c >> 24)), RGBA::hex("61afef80")}, "█"};
+  }
+
+  // a layer with a different translucent cell everywhere, composited whole
+  Buffer layer {size};
+  for (std::size_t x = 0; x < size.x; ++x) {
+    for (std::size_t y = 0; y < size.y; ++y) {
+      auto const c = rng();
+      layer.fill_span(Point{static_cast<std::ptrdiff_t>(x), static_cast<std::ptrdiff_t>(y)}, 1, Cell{1, Style{Style::Bit_24, 0, RGBA(static_cast<std::uint8_t>(c), static_cast<std::uint8_t>(c >> 8), static_cast<std::uint8_t>(c >> 16), static_cast<std::uint8_t>(c >> 24)), RGBA::hex("61afef80")}, "▄"});
+    }
+  }
+
+  std::cout << size.x << "x" << size.y << ", " << frames << " frames\n";
+  bool ok {true};
+
+  // a row at a time, the runs fill_rect hands to the blend
+  std::vector<Cell> old_buf;
+  report("fill per cell", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      old_buf.assign(screen.data(), screen.data() + cells);
+      for (std::size_t x = 0; x < size.x; ++x) {
+        Over_cell const over {bars[x].style};
+        for (std::size_t y = 0; y < size.y; ++y) {
+          blend_cell(old_buf[y * size.x + x], bars[x], over);
+        }
+      }
+      keep(old_buf);
+    }
+  }), cells * frames, "cells");
+  Buffer buf;
+  report("fill span", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      buf = screen;
+      for (std::size_t x = 0; x < size.x; ++x) {
+        buf.fill_rect(Point{static_cast<std::ptrdiff_t>(x), 0}, Size{1, size.y}, bars[x]);
+      }
+      keep(buf);
+    }
+  }), cells * frames, "cells");
+  ok = ok && same(buf, old_buf);
+
+  // fills run down a column, compose runs along rows with a new source in
+  // every cell
+  report("compose per cell", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      old_buf.assign(screen.data(), screen.data() + cells);
+      for (std::size_t j = 0; j < cells; ++j) {
+        auto const& cell = layer.data()[j];
+        blend_cell(old_buf[j], cell, Over_cell {cell.style});
+      }
+      keep(old_buf);
+    }
+  }), cells * frames, "cells");
+  report("compose span", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      buf = screen;
+      buf.compose(layer);
+      keep(buf);
+    }
+  }), cells * frames, "cells");
+  ok = ok && same(buf, old_buf);
+
+  if (!ok) {
+    std::cerr << "the span blend differs from the per cell blend\n";
+    return 1;
+  }
+  return 0;
+}
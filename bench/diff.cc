@@ -0,0 +1,138 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.hh"
+
+#include "app/window.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// the per-cell compare the frame diff made before the span kernels, every
+// field of every cell checked in turn
+static void rows_scalar(Encoder& enc, Buffer const& cur, Buffer const& prev) {
+  auto const width = cur.size().x;
+  for (std::size_t y = 0; y < cur.size().y; ++y) {
+    auto const* cells = cur.data() + y * cur.stride();
+    auto const* prevs = prev.data() + y * prev.stride();
+    for (std::size_t x = 0; x < width; ++x) {
+      auto const& cell = cells[x];
+      auto const& last = prevs[x];
+      if (cell.text != last.text ||
+          cell.style.attr != last.style.attr ||
+          cell.style.type != last.style.type ||
+          cell.style.fg != last.style.fg ||
+          cell.style.bg != last.style.bg) {
+        enc.cursor_move(cells, Pos(x, y));
+        enc.sgr(cell.style);
+        enc.line += cell.text.str();
+        enc.cursor_advance(cell.text.cols(), width);
+      }
+    }
+  }
+}
+
+static void rows_span(Encoder& enc, Buffer const& cur, Buffer const& prev) {
+  enc.rows(cur, prev, 0, cur.size().y, true);
+}
+
+// average time per frame of diffing and encoding cur against prev
+template<typename F>
+static void run(std::string const& name, Buffer const& cur, Buffer const& prev, std::size_t const frames, F const& rows) {
+  Encoder enc;
+  std::size_t bytes {0};
+  auto const ms = bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      enc.line.clear();
+      enc.cursor_valid = false;
+      enc.style = Style{};
+      rows(enc, cur, prev);
+      bytes = enc.line.size();
+      keep(enc.line);
+    }
+  });
+  report(name, ms / static_cast<double>(frames), cur.size().x * cur.size().y, "cells");
+  std::cout << "  " << bytes << " bytes\n";
+}
+
+int main() {
+  Size const size {400, 120};
+  std::size_t const frames {50};
+  Style const base {Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("1b1e24"), OB::Prism::RGBA::hex("1b1e24")};
+  Style const bar {Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("df6c3e"), OB::Prism::RGBA::hex("1b1e24")};
+  std::cout << size.x << "x" << size.y << ", time per frame\n";
+
+  Buffer const prev {size, Cell{0, base, " "}};
+
+  // unchanged, the full scan with nothing to send
+  Buffer same {prev};
+
+  // typical, a few percent of the cells changed, bars and text scattered over
+  // the screen
+  Buffer typical {prev};
+  std::mt19937 rng {7};
+  for (std::size_t i = 0; i < size.x * size.y / 32; ++i) {
+    auto& cell = typical.data()[rng() % (size.x * size.y)];
+    cell = Cell{1, bar, "█"};
+  }
+
+  // worst case, every cell changed, alternating styles
+  Buffer worst {prev};
+  for (std::size_t i = 0; i < size.x * size.y; ++i) {
+    worst.data()[i] = Cell{1, i % 2 ? bar : base, "▄"};
+  }
+
+  for (auto const& [name, cur] : {std::make_pair("unchanged", &same), std::make_pair("typical", &typical), std::make_pair("worst", &worst)}) {
+    run(std::string{name} + " scalar", *cur, prev, frames, rows_scalar);
+    run(std::string{name} + " span", *cur, prev, frames, rows_span);
+  }
+
+  return 0;
+}
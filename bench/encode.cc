@@ -0,0 +1,204 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.hh"
+
+#include "app/window.hh"
+#include "ob/term.hh"
+#include "ob/prism.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+// the encoder before the cursor and colour work, an absolute cursor move and
+// truecolour sequences for every changed cell
+static void old_rows(std::string& line, Style& style, Buffer const& cur, Buffer const& prev) {
+  auto const truecolour = [&](char const* lead, OB::Prism::RGBA const& rgba) {
+    line += lead;
+    line += std::to_string(rgba.r());
+    line += ";";
+    line += std::to_string(rgba.g());
+    line += ";";
+    line += std::to_string(rgba.b());
+    line += "m";
+  };
+  for (std::size_t y = 0; y < cur.size().y; ++y) {
+    for (std::size_t x = 0; x < cur.size().x; ++x) {
+      auto const& cell = cur.at(Pos(x, y));
+      auto const& last = prev.at(Pos(x, y));
+      if (cell.text == last.text &&
+          cell.style.attr == last.style.attr &&
+          cell.style.type == last.style.type &&
+          cell.style.fg == last.style.fg &&
+          cell.style.bg == last.style.bg) {
+        continue;
+      }
+      bool diff_fg {style.fg != cell.style.fg};
+      bool diff_bg {style.bg != cell.style.bg};
+      line += aec::cursor_set(x + 1, y + 1);
+      if (style.type != cell.style.type) {
+        style.type = cell.style.type;
+        if (style.type == Style::Type::Default) {line += aec::clear;}
+      }
+      if (style.attr != cell.style.attr) {
+        diff_fg = true;
+        diff_bg = true;
+        style.attr = cell.style.attr;
+        line += aec::clear;
+        if (style.attr & Style::Bold) {line += aec::bold;}
+        if (style.attr & Style::Reverse) {line += aec::reverse;}
+        if (style.attr & Style::Underline) {line += aec::underline;}
+      }
+      if (cell.style.type == Style::Type::Clear) {
+        style = Style();
+        line += aec::clear;
+      }
+      else if (cell.style.type == Style::Bit_24) {
+        if (diff_fg) {
+          style.fg = cell.style.fg;
+          truecolour("\x1b[38;2;", style.fg);
+        }
+        if (diff_bg) {
+          style.bg = cell.style.bg;
+          truecolour("\x1b[48;2;", style.bg);
+        }
+      }
+      line += cell.text.str();
+    }
+  }
+}
+
+// a seeded stand in for the game, bars of a terrain scrolling left a column
+// a frame, shaded along a ramp, faded posts crossing them and a status row
+static std::vector<Buffer> scene(Size const size, std::size_t const frames, Style const& base) {
+  std::mt19937 rng {7};
+  std::vector<std::size_t> terrain(size.x + frames);
+  std::size_t h {size.y / 3};
+  for (auto& e : terrain) {
+    h = std::clamp<std::size_t>(h + rng() % 3 - 1, 2, size.y - 4);
+    e = h;
+  }
+  static std::array<Glyph, 8> const bar {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+  static Prepared_text const title {"FLOATYBOX v0.1.0"};
+  auto const bg = base.bg;
+
+  std::vector<Buffer> out;
+  Buffer buf {size, Cell{0, base, " "}};
+  for (std::size_t i = 0; i < frames; ++i) {
+    buf.reset(Cell{0, base, " "});
+    for (std::size_t x = 0; x < size.x; ++x) {
+      auto const height = terrain[x + i];
+      auto const shade = static_cast<std::uint8_t>(96 + (height * 159) / size.y);
+      Style const style {Style::Bit_24, 0, OB::Prism::RGBA{shade, static_cast<std::uint8_t>(shade / 2), std::uint8_t{62}, std::uint8_t{255}}, bg};
+      buf.fill_rect(Point{static_cast<std::ptrdiff_t>(x), 0}, Size{1, height}, Cell{1, style, bar[7]});
+      buf.fill_span(Point{static_cast<std::ptrdiff_t>(x), static_cast<std::ptrdiff_t>(height)}, 1, Cell{1, style, bar[(x + i) % 8]});
+    }
+    for (std::size_t post = (size.x - i % size.x) % 24; post < size.x; post += 24) {
+      Style const faded {Style::Bit_24, 0, OB::Prism::RGBA{std::uint8_t{97}, std::uint8_t{175}, std::uint8_t{239}, static_cast<std::uint8_t>(64 + post % 128)}, bg};
+      buf.fill_rect(Point{static_cast<std::ptrdiff_t>(post), static_cast<std::ptrdiff_t>(size.y / 4)}, Size{2, size.y / 2}, Cell{2, faded, bar[7]});
+    }
+    Style const ui {Style::Bit_24, Style::Bold, OB::Prism::RGBA::hex("abb2bf"), OB::Prism::RGBA::hex("282c34")};
+    buf.put(Pos{0, size.y - 1}, title, ui);
+    buf.put(Pos{size.x - 4, size.y - 1}, std::to_string(i), ui);
+    out.emplace_back(buf);
+  }
+  return out;
+}
+
+// time and bytes per frame of encoding every frame against the one before
+template<typename F>
+static void run(std::string const& name, std::vector<Buffer> const& frames, F const& rows) {
+  std::size_t bytes {0};
+  auto const ms = bench([&]() {
+    bytes = 0;
+    for (std::size_t i = 1; i < frames.size(); ++i) {
+      bytes += rows(frames[i], frames[i - 1]);
+    }
+  });
+  auto const count = frames.size() - 1;
+  report(name, ms / static_cast<double>(count), frames[0].size().x * frames[0].size().y, "cells");
+  std::cout << "  " << bytes / count << " bytes per frame\n";
+}
+
+int main() {
+  std::size_t const frames {200};
+  Style const base {Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("1b1e24"), OB::Prism::RGBA::hex("1b1e24")};
+
+  for (auto const size : {Size{80, 24}, Size{120, 40}, Size{300, 90}}) {
+    std::cout << size.x << "x" << size.y << ", " << frames << " frames, time per frame\n";
+    auto const scene_frames = scene(size, frames, base);
+
+    {
+      std::string line;
+      Style style;
+      run("old", scene_frames, [&](Buffer const& cur, Buffer const& prev) {
+        line.clear();
+        old_rows(line, style, cur, prev);
+        keep(line);
+        return line.size();
+      });
+    }
+
+    for (auto const depth : {Style::Bit_24, Style::Bit_8, Style::Bit_4}) {
+      Encoder enc;
+      enc.depth = depth;
+      run("new " + std::to_string(depth == Style::Bit_24 ? 24 : depth == Style::Bit_8 ? 8 : 4) + " bit", scene_frames, [&](Buffer const& cur, Buffer const& prev) {
+        enc.line.clear();
+        enc.rows(cur, prev, 0, cur.size().y, false);
+        keep(enc.line);
+        return enc.line.size();
+      });
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.hh"
+
+#include "app/window.hh"
+
+#include <cmath>
+#include <cstddef>
+
+#include <array>
+#include <string>
+#include <vector>
+#include <iostream>
+
+using Position = Vec2n<double>;
+
+static std::array<Glyph, 8> const bar_vertical {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+
+// a vertical bar drawn a cell at a time, as App::draw_vertical did before the
+// span and rect fills, a floored position and a temporary cell for every cell
+static void bar_cells(Buffer& buf, Position const pos, Size const size, Style const& init_style) {
+  auto const eighth = static_cast<std::size_t>(std::floor((pos.y + static_cast<double>(size.y)) * 8)) % 8;
+  if (eighth == 0) {
+    for (std::size_t y = 0; y < size.y; ++y) {
+      for (std::size_t x = 0; x < size.x; ++x) {
+        buf(Pos{static_cast<std::size_t>(std::floor(pos.x + static_cast<double>(x))), static_cast<std::size_t>(std::floor(pos.y + static_cast<double>(y)))}, Cell{1, init_style, bar_vertical[7]});
+      }
+    }
+    return;
+  }
+  for (std::size_t y = 0; y <= size.y; ++y) {
+    Glyph block;
+    auto style = init_style;
+    if (y == 0) {
+      block = bar_vertical[eighth];
+      std::swap(style.fg, style.bg);
+    }
+    else if (y == size.y) {
+      block = bar_vertical[eighth];
+    }
+    else {
+      block = bar_vertical[7];
+    }
+    for (std::size_t x = 0; x < size.x; ++x) {
+      buf(Pos{static_cast<std::size_t>(std::floor(pos.x + static_cast<double>(x))), static_cast<std::size_t>(std::floor(pos.y + static_cast<double>(y)))}, Cell{1, style, block});
+    }
+  }
+}
+
+// the same bar clipped once and drawn in at most three fills
+static void bar_fill(Buffer& buf, Position const pos, Size const size, Style const& init_style) {
+  auto const origin = Point{static_cast<std::ptrdiff_t>(std::floor(pos.x)), static_cast<std::ptrdiff_t>(std::floor(pos.y))};
+  auto const eighth = static_cast<std::size_t>(std::floor((pos.y + static_cast<double>(size.y)) * 8)) % 8;
+  if (eighth == 0) {
+    buf.fill_rect(origin, size, Cell{1, init_style, bar_vertical[7]});
+    return;
+  }
+  auto style = init_style;
+  std::swap(style.fg, style.bg);
+  buf.fill_span(origin, size.x, Cell{1, style, bar_vertical[eighth]});
+  if (size.y > 1) {
+    buf.fill_rect(Point{origin.x, origin.y + 1}, Size{size.x, size.y - 1}, Cell{1, init_style, bar_vertical[7]});
+  }
+  buf.fill_span(Point{origin.x, origin.y + static_cast<std::ptrdiff_t>(size.y)}, size.x, Cell{1, init_style, bar_vertical[eighth]});
+}
+
+struct Goal {
+  Position pos;
+  Size size;
+};
+
+template<typename F>
+static void run(std::string const& name, Size const size, std::vector<Goal> const& goals, std::size_t const frames, F const& bar) {
+  Cell const base {0, Style{Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("1b1e24"), OB::Prism::RGBA::hex("1b1e24")}, " "};
+  // goals are drawn translucent over each other
+  Style const style {Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("98c379c0"), OB::Prism::RGBA::hex("1b1e24")};
+  Buffer buf {size, base};
+  auto const ms = bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      buf.reset(base);
+      // the goals move down an eighth of a cell each frame
+      auto const offset = static_cast<double>(i % 64) / 8.0;
+      for (auto const& goal : goals) {
+        bar(buf, Position{goal.pos.x, goal.pos.y - offset}, goal.size, style);
+      }
+      keep(buf);
+    }
+  });
+  report(name, ms, buf.blended() * frames, "cells");
+}
+
+int main() {
+  Size const size {1000, 200};
+  std::size_t const frames {100};
+
+  // many goals on screen, pairs of columns with a gap between them,
+  // overlapping their neighbours
+  std::vector<Goal> goals;
+  for (std::size_t i = 0; i < 120; ++i) {
+    auto const x = static_cast<double>(i * 8 % 990);
+    auto const gap = 20.0 + static_cast<double>(i % 7) * 3.0;
+    auto const low = 10.0 + static_cast<double>(i * 13 % 100) + 0.375;
+    goals.emplace_back(Goal{Position{x, 0.0}, Size{4, static_cast<std::size_t>(low)}});
+    goals.emplace_back(Goal{Position{x, low + gap}, Size{4, static_cast<std::size_t>(static_cast<double>(size.y) - low - gap)}});
+  }
+
+  std::cout << size.x << "x" << size.y << ", " << goals.size() << " goals, " << frames << " frames\n";
+  run("per cell", size, goals, frames, bar_cells);
+  run("fill", size, goals, frames, bar_fill);
+
+  return 0;
+}
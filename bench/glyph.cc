@@ -0,0 +1,132 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.hh"
+
+#include "app/window.hh"
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+// a cell holding its text in a std::string, as Cell did before Glyph
+struct String_cell {
+  int zidx;
+  Style style;
+  std::string text {" "};
+};
+
+static bool differ(String_cell const& lhs, String_cell const& rhs) {
+  return lhs.text != rhs.text ||
+    lhs.style.attr != rhs.style.attr ||
+    lhs.style.type != rhs.style.type ||
+    lhs.style.fg != rhs.style.fg ||
+    lhs.style.bg != rhs.style.bg;
+}
+
+static bool differ(Cell const& lhs, Cell const& rhs) {
+  return lhs.text != rhs.text ||
+    lhs.style.attr != rhs.style.attr ||
+    lhs.style.type != rhs.style.type ||
+    lhs.style.fg != rhs.style.fg ||
+    lhs.style.bg != rhs.style.bg;
+}
+
+// the same frame work for either cell type, draw a bar glyph into every cell,
+// copy the frame and diff it against the previous one
+template<typename T, typename G>
+static void run(std::string const& name, std::size_t const cells, std::size_t const frames, G const& glyphs) {
+  Style const style {Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("df6c3e"), OB::Prism::RGBA::hex("1b1e24")};
+  std::vector<T> cur(cells, T{0, style, " "});
+  std::vector<T> prev(cells, T{0, style, " "});
+
+  report(name + " draw", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t x = 0; x < cells; ++x) {
+        cur[x] = T{1, style, glyphs[(x + i) % glyphs.size()]};
+      }
+      keep(cur);
+    }
+  }), cells * frames, "cells");
+
+  report(name + " copy", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t x = 0; x < cells; ++x) {
+        prev[x] = cur[x];
+      }
+      keep(prev);
+    }
+  }), cells * frames, "cells");
+
+  // every eighth cell changed
+  for (std::size_t x = 0; x < cells; x += 8) {
+    cur[x].text = glyphs[(x + 1) % glyphs.size()];
+  }
+  std::size_t changed {0};
+  report(name + " diff", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t x = 0; x < cells; ++x) {
+        changed += differ(cur[x], prev[x]);
+      }
+      keep(changed);
+    }
+  }), cells * frames, "cells");
+}
+
+int main() {
+  std::size_t const cells {300 * 90};
+  std::size_t const frames {100};
+  std::cout << cells << " cells, " << frames << " frames\n";
+
+  std::vector<std::string> const strings {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█", "#", " "};
+  std::vector<Glyph> const glyphs {strings.begin(), strings.end()};
+
+  run<String_cell>("string", cells, frames, strings);
+  run<Cell>("glyph", cells, frames, glyphs);
+
+  return 0;
+}
@@ -0,0 +1,167 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.hh"
+
+#include "app/window.hh"
+
+#include <cstddef>
+
+#include <vector>
+#include <iostream>
+
+// the cell grid as nested row vectors, as Buffer stored it before the flat
+// row-major layout, reached through two checked at() calls
+class Nested {
+public:
+  void size(Size const size, Cell const& cell) {
+    _size = size;
+    _value.clear();
+    for (std::size_t h = 0; h < _size.y; ++h) {
+      _value.emplace_back();
+      for (std::size_t w = 0; w < _size.x; ++w) {
+        _value.back().emplace_back(cell);
+      }
+    }
+  }
+
+  Cell& at(Pos const pos) {
+    return _value.at(pos.y).at(pos.x);
+  }
+
+  Cell& col(Pos const pos) {
+    return _value.at(_size.y - pos.y - 1).at(pos.x);
+  }
+
+private:
+  Size _size;
+  std::vector<std::vector<Cell>> _value;
+}; // class Nested
+
+int main() {
+  // the kiosk display size
+  Size const size {300, 90};
+  std::size_t const cells {size.x * size.y};
+  std::size_t const frames {100};
+  Cell const base {0, Style{Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("1b1e24"), OB::Prism::RGBA::hex("1b1e24")}, " "};
+  Cell const bar {1, Style{Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("df6c3e"), OB::Prism::RGBA::hex("1b1e24")}, "█"};
+
+  std::cout << size.x << "x" << size.y << ", " << frames << " frames\n";
+
+  Nested nested;
+  Buffer flat;
+
+  report("resize nested", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      nested.size(size, base);
+      keep(nested);
+    }
+  }), cells * frames, "cells");
+  report("resize flat", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      flat.size(size, base);
+      keep(flat);
+    }
+  }), cells * frames, "cells");
+
+  // drawing writes in world coordinates, origin bottom left
+  report("write nested col", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t y = 0; y < size.y; ++y) {
+        for (std::size_t x = 0; x < size.x; ++x) {
+          nested.col(Pos{x, y}) = bar;
+        }
+      }
+      keep(nested);
+    }
+  }), cells * frames, "cells");
+  report("write flat col", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t y = 0; y < size.y; ++y) {
+        for (std::size_t x = 0; x < size.x; ++x) {
+          flat.col(Pos{x, y}) = bar;
+        }
+      }
+      keep(flat);
+    }
+  }), cells * frames, "cells");
+  report("write flat row", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t y = 0; y < size.y; ++y) {
+        auto* row = flat.row(y);
+        for (std::size_t x = 0; x < size.x; ++x) {
+          row[x] = bar;
+        }
+      }
+      keep(flat);
+    }
+  }), cells * frames, "cells");
+
+  // rendering reads in screen coordinates, origin top left
+  std::size_t sum {0};
+  report("read nested at", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t y = 0; y < size.y; ++y) {
+        for (std::size_t x = 0; x < size.x; ++x) {
+          sum += static_cast<std::size_t>(nested.at(Pos{x, y}).zidx);
+        }
+      }
+      keep(sum);
+    }
+  }), cells * frames, "cells");
+  report("read flat data", bench([&]() {
+    for (std::size_t i = 0; i < frames; ++i) {
+      for (std::size_t y = 0; y < size.y; ++y) {
+        auto const* row = flat.data() + y * flat.stride();
+        for (std::size_t x = 0; x < size.x; ++x) {
+          sum += static_cast<std::size_t>(row[x].zidx);
+        }
+      }
+      keep(sum);
+    }
+  }), cells * frames, "cells");
+
+  return 0;
+}
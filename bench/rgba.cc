@@ -0,0 +1,250 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.hh"
+
+#include "ob/prism.hh"
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#include <tuple>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+
+using RGBA = OB::Prism::RGBA;
+
+// divide by 255 rounding to nearest, exact for v up to 255 * 255
+static std::uint8_t div255(unsigned int const v) {
+  return static_cast<std::uint8_t>((v + 128 + ((v + 128) >> 8)) >> 8);
+}
+
+// RGBA as four separate channels, compared through std::tie and parsed with
+// sscanf, as OB::Prism::RGBA was before it was packed
+class Fields {
+public:
+  Fields(std::uint8_t const r, std::uint8_t const g, std::uint8_t const b, std::uint8_t const a) : _r {r}, _g {g}, _b {b}, _a {a} {}
+  Fields() = default;
+
+  friend bool operator==(Fields const& lhs, Fields const& rhs) {
+    auto lr = lhs.r();
+    auto lg = lhs.g();
+    auto lb = lhs.b();
+    auto la = lhs.a();
+    auto rr = rhs.r();
+    auto rg = rhs.g();
+    auto rb = rhs.b();
+    auto ra = rhs.a();
+    return std::tie(lr, lg, lb, la) == std::tie(rr, rg, rb, ra);
+  }
+
+  Fields& operator+=(Fields const& obj) {
+    unsigned int const sa {obj.a()};
+    if (sa == 255 || a() == 0) {
+      *this = obj;
+      return *this;
+    }
+    if (sa == 0) {
+      return *this;
+    }
+    unsigned int const ia {255 - sa};
+    if (a() == 255) {
+      r(div255(obj.r() * sa + r() * ia));
+      g(div255(obj.g() * sa + g() * ia));
+      b(div255(obj.b() * sa + b() * ia));
+      return *this;
+    }
+    unsigned int const da {div255(a() * ia)};
+    unsigned int const oa {sa + da};
+    auto const channel = [&](unsigned int const src, unsigned int const dst) {
+      return static_cast<std::uint8_t>((src * sa + dst * da + oa / 2) / oa);
+    };
+    r(channel(obj.r(), r()));
+    g(channel(obj.g(), g()));
+    b(channel(obj.b(), b()));
+    a(static_cast<std::uint8_t>(oa));
+    return *this;
+  }
+
+  Fields& from_hex(std::string const& str) {
+    r(decode(str.substr(0, 2)));
+    g(decode(str.substr(2, 2)));
+    b(decode(str.substr(4, 2)));
+    a(str.size() == 8 ? decode(str.substr(6, 2)) : static_cast<std::uint8_t>(255));
+    return *this;
+  }
+
+  std::uint8_t r() const {return _r;}
+  Fields& r(std::uint8_t const v) {_r = v; return *this;}
+  std::uint8_t g() const {return _g;}
+  Fields& g(std::uint8_t const v) {_g = v; return *this;}
+  std::uint8_t b() const {return _b;}
+  Fields& b(std::uint8_t const v) {_b = v; return *this;}
+  std::uint8_t a() const {return _a;}
+  Fields& a(std::uint8_t const v) {_a = v; return *this;}
+
+private:
+  static std::uint8_t decode(std::string const& str) {
+    unsigned int hex {0};
+    std::sscanf(str.c_str(), "%02X", &hex);
+    return static_cast<std::uint8_t>(hex);
+  }
+
+  std::uint8_t _r {0};
+  std::uint8_t _g {0};
+  std::uint8_t _b {0};
+  std::uint8_t _a {0};
+}; // class Fields
+
+int main() {
+  std::size_t const count {1000000};
+  std::size_t const strings {100000};
+  std::mt19937 rng {7};
+
+  // destinations opaque like the screen, sources of any alpha, a quarter of
+  // the pairs equal
+  std::vector<RGBA> dst(count);
+  std::vector<RGBA> src(count);
+  std::vector<Fields> dst_fields(count);
+  std::vector<Fields> src_fields(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    auto const d = rng();
+    auto const s = i % 4 ? rng() : d;
+    dst[i] = RGBA(static_cast<std::uint8_t>(d), static_cast<std::uint8_t>(d >> 8), static_cast<std::uint8_t>(d >> 16), std::uint8_t{255});
+    src[i] = RGBA(static_cast<std::uint8_t>(s), static_cast<std::uint8_t>(s >> 8), static_cast<std::uint8_t>(s >> 16), static_cast<std::uint8_t>(i % 4 ? s >> 24 : 255));
+    dst_fields[i] = Fields(dst[i].r(), dst[i].g(), dst[i].b(), dst[i].a());
+    src_fields[i] = Fields(src[i].r(), src[i].g(), src[i].b(), src[i].a());
+  }
+
+  std::vector<std::string> hex(strings);
+  for (auto& str : hex) {
+    char buf[9] {};
+    std::snprintf(buf, sizeof(buf), "%08x", static_cast<unsigned int>(rng()));
+    str = buf;
+  }
+
+  std::cout << count << " colours, " << strings << " hex strings\n";
+
+  std::size_t same {0};
+  report("equality fields", bench([&]() {
+    for (std::size_t i = 0; i < count; ++i) {
+      same += dst_fields[i] == src_fields[i];
+    }
+    keep(same);
+  }), count, "colours");
+  report("equality packed", bench([&]() {
+    for (std::size_t i = 0; i < count; ++i) {
+      same += dst[i] == src[i];
+    }
+    keep(same);
+  }), count, "colours");
+
+  report("hex fields", bench([&]() {
+    for (auto const& str : hex) {
+      Fields val;
+      val.from_hex(str);
+      keep(val);
+    }
+  }), strings, "strings");
+  report("hex packed", bench([&]() {
+    for (auto const& str : hex) {
+      auto const val = RGBA::hex(str);
+      keep(val);
+    }
+  }), strings, "strings");
+
+  std::vector<Fields> out_fields(count);
+  std::vector<RGBA> out(count);
+  report("operator+= fields", bench([&]() {
+    for (std::size_t i = 0; i < count; ++i) {
+      out_fields[i] = dst_fields[i];
+      out_fields[i] += src_fields[i];
+    }
+    keep(out_fields);
+  }), count, "colours");
+  report("operator+= packed", bench([&]() {
+    for (std::size_t i = 0; i < count; ++i) {
+      out[i] = dst[i];
+      out[i] += src[i];
+    }
+    keep(out);
+  }), count, "colours");
+  report("blend packed", bench([&]() {
+    out = dst;
+    OB::Prism::blend(out.data(), src.data(), count);
+    keep(out);
+  }), count, "colours");
+
+  std::size_t wrong {0};
+  for (std::size_t i = 0; i < count; ++i) {
+    wrong += out[i].value() != (RGBA(dst[i]) += src[i]).value();
+  }
+
+  std::uint8_t const t {96};
+  report("lerp fields", bench([&]() {
+    for (std::size_t i = 0; i < count; ++i) {
+      auto const& l = dst_fields[i];
+      auto const& r = src_fields[i];
+      out_fields[i] = Fields(div255(l.r() * (255u - t) + r.r() * t), div255(l.g() * (255u - t) + r.g() * t),
+        div255(l.b() * (255u - t) + r.b() * t), div255(l.a() * (255u - t) + r.a() * t));
+    }
+    keep(out_fields);
+  }), count, "colours");
+  report("lerp packed", bench([&]() {
+    OB::Prism::lerp(out.data(), dst.data(), src.data(), count, t);
+    keep(out);
+  }), count, "colours");
+
+  for (std::size_t i = 0; i < count; ++i) {
+    auto const& f = out_fields[i];
+    wrong += out[i].value() != RGBA(f.r(), f.g(), f.b(), f.a()).value();
+  }
+  std::cout << wrong << " batch results differ from the scalar ones\n";
+
+  return wrong ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.hh"
+
+#include "app/window.hh"
+#include "ob/text.hh"
+
+#include <unicode/uchar.h>
+#include <unicode/utext.h>
+#include <unicode/brkiter.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+// the graphemes of str and their columns, segmented as View did before the
+// fast paths, a new UText and break iterator for every string
+static std::size_t old_view(std::string_view const str, std::vector<std::pair<std::string_view, std::size_t>>& view) {
+  view.clear();
+  if (str.empty()) {return 0;}
+
+  UErrorCode ec = U_ZERO_ERROR;
+  std::unique_ptr<UText, decltype(&utext_close)> text (
+    utext_openUTF8(nullptr, str.data(), static_cast<std::int64_t>(str.size()), &ec),
+    utext_close);
+  if (U_FAILURE(ec)) {throw std::runtime_error("failed to create utext");}
+  std::unique_ptr<icu::BreakIterator> iter {icu::BreakIterator::createCharacterInstance(icu::Locale::getDefault(), ec)};
+  if (U_FAILURE(ec)) {throw std::runtime_error("failed to create break iterator");}
+  iter->setText(text.get(), ec);
+  if (U_FAILURE(ec)) {throw std::runtime_error("failed to set break iterator text");}
+
+  std::size_t size {0};
+  while (iter->next() != icu::BreakIterator::DONE) {++size;}
+  view.reserve(size);
+
+  std::size_t cols {0};
+  auto begin = iter->first();
+  for (auto end = iter->next(); end != icu::BreakIterator::DONE; begin = end, end = iter->next()) {
+    auto const width = u_getIntPropertyValue(utext_char32At(text.get(), begin), UCHAR_EAST_ASIAN_WIDTH);
+    std::size_t const n = width == U_EA_FULLWIDTH || width == U_EA_WIDE ? 2 : 1;
+    view.emplace_back(str.substr(static_cast<std::size_t>(begin), static_cast<std::size_t>(end - begin)), n);
+    cols += n;
+  }
+  return cols;
+}
+
+int main() {
+  std::size_t const count {20000};
+  std::cout << count << " strings\n";
+
+  std::vector<std::pair<std::string, std::string>> const strings {
+    {"ascii", "Click or <Space> to float!"},
+    {"box", "█"},
+    {"bars", "▁▂▃▄▅▆▇█"},
+    {"emoji", "👍"},
+    {"family", "👨‍👩‍👧‍👦 ok"},
+  };
+
+  std::vector<std::pair<std::string_view, std::size_t>> scratch;
+  for (auto const& [name, str] : strings) {
+    std::size_t cols {0};
+    auto const old_ms = bench([&]() {
+      for (std::size_t i = 0; i < count; ++i) {
+        cols += old_view(str, scratch);
+      }
+      keep(cols);
+    });
+    report(name + " old view", old_ms, count, "strings");
+
+    // segmented on every draw, as put(string_view) does
+    auto const view_ms = bench([&]() {
+      for (std::size_t i = 0; i < count; ++i) {
+        OB::Text::View const view {str};
+        cols += view.cols();
+      }
+      keep(cols);
+    });
+    report(name + " view", view_ms, count, "strings");
+
+    // segmented once, as put(Prepared_text) draws
+    Prepared_text const text {str};
+    auto const prepared_ms = bench([&]() {
+      for (std::size_t i = 0; i < count; ++i) {
+        for (auto const& glyph : text.glyphs()) {
+          cols += glyph.cols();
+        }
+      }
+      keep(cols);
+    });
+    report(name + " prepared", prepared_ms, count, "strings");
+  }
+
+  return 0;
+}
@@ -0,0 +1,181 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2019 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// generates src/ob/width.hh from the unicode data of the installed icu
+//
+//   g++ -std=c++17 res/width.cc -licuuc -o width && ./width > src/ob/width.hh
+//
+// built with -DCHECK -Isrc it instead compares the existing table against icu
+// for every code point and exits non-zero on the first difference
+
+#include <unicode/uchar.h>
+#include <unicode/uversion.h>
+
+#ifdef CHECK
+#include "ob/width.hh"
+#endif
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// two columns for wide and fullwidth east asian characters and for those
+// presented as emoji by default
+static bool wide(UChar32 const ch) {
+  auto const width = u_getIntPropertyValue(ch, UCHAR_EAST_ASIAN_WIDTH);
+  return width == U_EA_FULLWIDTH || width == U_EA_WIDE ||
+    u_hasBinaryProperty(ch, UCHAR_EMOJI_PRESENTATION);
+}
+
+int main() {
+  constexpr UChar32 end {0x110000};
+
+#ifdef CHECK
+  for (UChar32 ch = 0; ch < end; ++ch) {
+    if (OB::Text::width(static_cast<char32_t>(ch)) != (wide(ch) ? 2u : 1u)) {
+      std::fprintf(stderr, "mismatch at U+%04X\n", static_cast<unsigned int>(ch));
+      return 1;
+    }
+  }
+  std::fprintf(stderr, "table matches icu %s\n", U_ICU_VERSION);
+  return 0;
+#endif
+
+  // blocks of 256 code points as a bit per code point, identical blocks shared
+  using Block = std::array<std::uint64_t, 4>;
+  std::vector<Block> blocks;
+  std::vector<std::size_t> index;
+  for (UChar32 base = 0; base < end; base += 256) {
+    Block block {};
+    for (UChar32 ch = base, last = base + 256; ch < last; ++ch) {
+      if (wide(ch)) {
+        block[(ch >> 6) & 3] |= std::uint64_t {1} << (ch & 63);
+      }
+    }
+    std::size_t i {0};
+    while (i < blocks.size() && blocks[i] != block) {++i;}
+    if (i == blocks.size()) {blocks.emplace_back(block);}
+    index.emplace_back(i);
+  }
+  if (blocks.size() > 256) {
+    std::fprintf(stderr, "too many blocks for a byte index\n");
+    return 1;
+  }
+
+  // the license header of this file
+  std::ifstream self {__FILE__};
+  std::string line;
+  while (std::getline(self, line)) {
+    std::cout << line << "\n";
+    if (line == "*/") {break;}
+  }
+
+  std::cout
+  << "\n"
+  << "// generated by res/width.cc from the unicode data of icu " << U_ICU_VERSION << ", do not edit\n"
+  << "\n"
+  << "#ifndef OB_WIDTH_HH\n"
+  << "#define OB_WIDTH_HH\n"
+  << "\n"
+  << "#include <cstddef>\n"
+  << "#include <cstdint>\n"
+  << "\n"
+  << "namespace OB::Text\n"
+  << "{\n"
+  << "\n"
+  << "namespace Width\n"
+  << "{\n"
+  << "\n"
+  << "// block of each 256 code points\n"
+  << "inline constexpr std::uint8_t index[" << index.size() << "] {";
+  for (std::size_t i = 0; i < index.size(); ++i) {
+    std::cout << (i % 24 == 0 ? "\n  " : " ") << index[i] << ",";
+  }
+  std::cout
+  << "\n};\n"
+  << "\n"
+  << "// a bit per code point, set when it takes up two columns\n"
+  << "inline constexpr std::uint64_t block[" << blocks.size() << "][4] {";
+  char buf[32];
+  for (auto const& block : blocks) {
+    std::cout << "\n  {";
+    for (std::size_t i = 0; i < block.size(); ++i) {
+      std::snprintf(buf, sizeof(buf), "0x%016llx", static_cast<unsigned long long>(block[i]));
+      std::cout << (i ? ", " : "") << buf;
+    }
+    std::cout << "},";
+  }
+  std::cout
+  << "\n};\n"
+  << "\n"
+  << "} // namespace Width\n"
+  << "\n"
+  << "// columns a grapheme starting with code point ch takes up in a terminal,\n"
+  << "// two for wide, fullwidth and emoji presentation characters, otherwise one\n"
+  << "constexpr std::size_t width(char32_t const ch)\n"
+  << "{\n"
+  << "  if (ch >= 0x110000)\n"
+  << "  {\n"
+  << "    return 1;\n"
+  << "  }\n"
+  << "\n"
+  << "  auto const& block = Width::block[Width::index[ch >> 8]];\n"
+  << "\n"
+  << "  return 1 + ((block[(ch >> 6) & 3] >> (ch & 63)) & 1);\n"
+  << "}\n"
+  << "\n"
+  << "} // namespace OB::Text\n"
+  << "\n"
+  << "#endif // OB_WIDTH_HH\n";
+
+  return 0;
+}
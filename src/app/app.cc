@@ -55,15 +55,22 @@ SOFTWARE.
 #include <cstdlib>
 
 #include <array>
+#include <chrono>
+#include <charconv>
 #include <memory>
 #include <string>
 #include <thread>
 #include <vector>
+#include <fstream>
+#include <iterator>
+#include <iomanip>
 #include <utility>
+#include <algorithm>
+#include <stdexcept>
 #include <functional>
 #include <string_view>
 
-App::App(OB::Parg const& pg) : _pg {pg} {
+App::App(OB::Parg& pg) : _pg {pg} {
 }
 
 App::~App() {
@@ -100,6 +107,7 @@ void App::screen_init() {
 }
 
 void App::screen_deinit() {
+  _win.drain();
   std::cout
   << aec::mouse_disable
   << aec::nl
@@ -133,6 +141,9 @@ void App::await_tick() {
     }
 
     render();
+    if (_adaptive) {
+      adapt();
+    }
     await_tick();
   });
 }
@@ -521,107 +532,194 @@ void App::increase_velocity() {
 }
 
 void App::draw() {
-  draw_game();
-  draw_ui();
-}
+  if (_ui_fill.cols() != _width) {
+    _ui_fill = Prepared_text(std::string(_width, ' '));
+  }
 
-void App::draw_vertical(Object const& obj, std::function<void(Style&)> const& fn) {
-  auto init_style = _cfg.color ? Style{Style::Bit_24, 0, _cfg.style.box, _cfg.style.bg} : _style_default;
-  if (fn) {
-    fn(init_style);
+  auto const size = Size{_width, _height};
+  for (auto& layer : _layers) {
+    if (layer.buf.size() != size) {
+      layer.buf.size(size);
+      layer.dirty = true;
+    }
   }
 
-  if (static_cast<int>(std::floor((obj.position.y + obj.size.y) * 8)) % 8 == 0) {
-    for (std::size_t y = 0; y < obj.size.y; ++y) {
-      for (std::size_t x = 0; x < obj.size.x; ++x) {
-        _win.buf(Pos{static_cast<std::size_t>(std::floor(obj.position.x + x)), static_cast<std::size_t>(std::floor(obj.position.y + y))}, Cell{1, init_style, _bar_vertical[7]});
+  // the world and the box change with the cells their bars cover, not with
+  // every step of the simulation
+  {
+    Layer_key key;
+    for (std::size_t i = 0; i < _trail.size(); ++i) {
+      if (!trail_shown(i)) {continue;}
+      key_bar(key, _trail[i]);
+      key(trail_alpha(static_cast<double>(i)));
+    }
+    for (auto const& goal : _goals) {
+      key(static_cast<std::uint64_t>(goal.state));
+      for (auto const& sprite : goal.sprites) {
+        key_bar(key, sprite);
+        key(goal_alpha(goal, sprite));
       }
     }
+    layer_key(Layer::World, key);
+  }
+  {
+    Layer_key key;
+    key_bar(key, _box);
+    layer_key(Layer::Actors, key);
   }
-  else {
-    for (std::size_t y = 0; y <= obj.size.y; ++y) {
-      std::string block;
-      auto style = init_style;
-
-      if (y == 0) {
-        block = _bar_vertical[static_cast<std::size_t>(std::floor((obj.position.y + obj.size.y) * 8)) % 8];
 
-        if (_cfg.color) {
-          std::swap(style.fg, style.bg);
-        }
-        else {
-          style.attr = Style::Reverse;
-        }
-      }
-      else if (y == obj.size.y) {
-        block = _bar_vertical[static_cast<std::size_t>(std::floor((obj.position.y + obj.size.y) * 8)) % 8];
-      }
-      else {
-        block = _bar_vertical[7];
-      }
+  // the ui only changes with the values it shows
+  stats();
+  layer_key(Layer::Ui, Layer_key()
+    (static_cast<std::uint64_t>(std::round(_fps_actual)))
+    (_score)
+    (_high_score)
+    (_playing)
+    (_stats));
+
+  // the prompt follows the readline state, it is drawn while open and
+  // erased once after it closes
+  {
+    auto& prompt = _layers[Layer::Prompt];
+    auto const key = Layer_key()(_readline._typing).value();
+    if (_readline._typing || key != prompt.key) {
+      prompt.key = key;
+      prompt.dirty = true;
+    }
+  }
 
-      for (std::size_t x = 0; x < obj.size.x; ++x) {
-        _win.buf(Pos{static_cast<std::size_t>(std::floor(obj.position.x + x)), static_cast<std::size_t>(std::floor(obj.position.y + y))}, Cell{1, style, block});
-      }
+  for (std::size_t i = 0; i < _layers.size(); ++i) {
+    auto& layer = _layers[i];
+    if (!layer.dirty) {continue;}
+    layer.dirty = false;
+    layer.buf.erase();
+    switch (i) {
+      case Layer::World: draw_game(); break;
+      case Layer::Actors: draw_box(); break;
+      case Layer::Ui: draw_ui(); break;
+      case Layer::Prompt: draw_prompt(); break;
+      default: break;
     }
   }
+
+  for (auto const& layer : _layers) {
+    _win.buf.compose(layer.buf);
+  }
+}
+
+void App::layer_key(std::size_t const layer, Layer_key const& key) {
+  auto& obj = _layers[layer];
+  if (key.value() != obj.key) {
+    obj.key = key.value();
+    obj.dirty = true;
+  }
+}
+
+void App::key_bar(Layer_key& key, Object const& obj) {
+  // the cells a bar covers follow from these, see draw_vertical
+  auto const floor = [](double const val) {
+    return static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(val)));
+  };
+  key
+    (floor(obj.position.x))
+    (floor(obj.position.y))
+    (floor((obj.position.y + obj.size.y) * 8))
+    (obj.size.x)
+    (obj.size.y);
+}
+
+std::uint8_t App::trail_alpha(double const i) const {
+  return _fade ? static_cast<std::uint8_t>(255 * (i / _trail.size())) : 255;
+}
+
+std::uint8_t App::goal_alpha(Goal const& goal, Object const& sprite) const {
+  if (!_fade) {return 255;}
+  if (goal.state == Goal::State::Pass && sprite.position.x + sprite.size.x < _box.position.x) {
+    return static_cast<std::uint8_t>(255 * ((sprite.position.x + sprite.size.x) / _box.position.x));
+  }
+  if (sprite.position.x > _box.position.x) {
+    return static_cast<std::uint8_t>(255 * ((sprite.position.x - _width) / (_box.position.x - _width)));
+  }
+  return 255;
 }
 
-void App::draw_horizontal(Object const& obj, std::function<void(Style&)> const& fn) {
-  auto init_style = _cfg.color ? Style{Style::Bit_24, 0, _cfg.style.box, _cfg.style.bg} : _style_default;
+void App::redraw() {
+  for (auto& layer : _layers) {
+    layer.dirty = true;
+  }
+}
+
+void App::draw_vertical(Buffer& buf, Object const& obj, std::function<void(Style&)> const& fn) {
+  auto init_style = _cfg.color ? Style{Style::Bit_24, 0, _palette.box, _cfg.style.bg} : _style_default;
   if (fn) {
     fn(init_style);
   }
 
-  if (static_cast<int>(std::floor((obj.position.x + obj.size.x) * 8)) % 8 == 0) {
-    for (std::size_t x = 0; x < obj.size.x; ++x) {
-      for (std::size_t y = 0; y < obj.size.y; ++y) {
-        _win.buf(Pos{static_cast<std::size_t>(std::floor(obj.position.x + x)), static_cast<std::size_t>(std::floor(obj.position.y + y))}, Cell{1, init_style, _bar_horizontal[7]});
-      }
-    }
+  auto const origin = Point{static_cast<std::ptrdiff_t>(std::floor(obj.position.x)), static_cast<std::ptrdiff_t>(std::floor(obj.position.y))};
+  auto const eighth = static_cast<std::size_t>(std::floor((obj.position.y + obj.size.y) * 8)) % 8;
+
+  if (eighth == 0) {
+    buf.fill_rect(origin, obj.size, Cell{1, init_style, _bar_vertical[7]});
+    return;
+  }
+
+  // partial top and bottom rows around a run of full rows
+  auto style = init_style;
+  if (_cfg.color) {
+    std::swap(style.fg, style.bg);
   }
   else {
-    for (std::size_t x = 0; x <= obj.size.x; ++x) {
-      std::string block;
-      auto style = init_style;
+    style.attr = Style::Reverse;
+  }
+  buf.fill_span(origin, obj.size.x, Cell{1, style, _bar_vertical[eighth]});
+  if (obj.size.y > 1) {
+    buf.fill_rect(Point{origin.x, origin.y + 1}, Size{obj.size.x, obj.size.y - 1}, Cell{1, init_style, _bar_vertical[7]});
+  }
+  buf.fill_span(Point{origin.x, origin.y + static_cast<std::ptrdiff_t>(obj.size.y)}, obj.size.x, Cell{1, init_style, _bar_vertical[eighth]});
+}
+
+void App::draw_horizontal(Buffer& buf, Object const& obj, std::function<void(Style&)> const& fn) {
+  auto init_style = _cfg.color ? Style{Style::Bit_24, 0, _palette.box, _cfg.style.bg} : _style_default;
+  if (fn) {
+    fn(init_style);
+  }
 
-      if (x == 0) {
-        block = _bar_horizontal[static_cast<std::size_t>(std::floor((obj.position.x + obj.size.x) * 8)) % 8];
+  auto const origin = Point{static_cast<std::ptrdiff_t>(std::floor(obj.position.x)), static_cast<std::ptrdiff_t>(std::floor(obj.position.y))};
+  auto const eighth = static_cast<std::size_t>(std::floor((obj.position.x + obj.size.x) * 8)) % 8;
 
-        if (_cfg.color) {
-          std::swap(style.fg, style.bg);
-        }
-        else {
-          style.attr = Style::Reverse;
-        }
-      }
-      else if (x == obj.size.x) {
-        block = _bar_horizontal[static_cast<std::size_t>(std::floor((obj.position.x + obj.size.x) * 8)) % 8];
-      }
-      else {
-        block = _bar_horizontal[7];
-      }
+  if (eighth == 0) {
+    buf.fill_rect(origin, obj.size, Cell{1, init_style, _bar_horizontal[7]});
+    return;
+  }
 
-      for (std::size_t y = 0; y < obj.size.y; ++y) {
-        _win.buf(Pos{static_cast<std::size_t>(std::floor(obj.position.x + x)), static_cast<std::size_t>(std::floor(obj.position.y + y))}, Cell{1, style, block});
-      }
-    }
+  // partial left and right columns around a run of full columns
+  auto style = init_style;
+  if (_cfg.color) {
+    std::swap(style.fg, style.bg);
   }
+  else {
+    style.attr = Style::Reverse;
+  }
+  buf.fill_rect(origin, Size{1, obj.size.y}, Cell{1, style, _bar_horizontal[eighth]});
+  if (obj.size.x > 1) {
+    buf.fill_rect(Point{origin.x + 1, origin.y}, Size{obj.size.x - 1, obj.size.y}, Cell{1, init_style, _bar_horizontal[7]});
+  }
+  buf.fill_rect(Point{origin.x + static_cast<std::ptrdiff_t>(obj.size.x), origin.y}, Size{1, obj.size.y}, Cell{1, init_style, _bar_horizontal[eighth]});
 }
 
 void App::draw_game() {
   draw_trails();
   draw_goals();
-  draw_box();
 }
 
 void App::draw_ui() {
   draw_ui_top();
   draw_ui_bottom();
-  draw_prompt();
+  draw_stats();
 }
 
 void App::draw_ui_top() {
+  auto& buf = _layers[Layer::Ui].buf;
   auto style = _cfg.color ? Style{Style::Bit_24, 0, _cfg.style.ui, _cfg.style.ui_bg} : _style_default;
   if (_cfg.color) {
     style.attr |= Style::Bold;
@@ -630,20 +728,21 @@ void App::draw_ui_top() {
     style.attr |= Style::Reverse;
   }
 
-  _win.buf.put(Pos{0, _height - 1}, Cell{1, style, std::string(_width, ' ')});
+  buf.put(Pos{0, _height - 1}, _ui_fill, style);
 
-  _win.buf.put(Pos{(_width / 2) - (_ui_name.size() / 2), _height - 1}, Cell{1, style, _ui_name});
+  buf.put(Pos{(_width / 2) - (_ui_name.cols() / 2), _height - 1}, _ui_name, style);
 
   style.fg.a(255);
-  _win.buf.put(Pos{0, _height - 1}, Cell{1, style, std::to_string(static_cast<int>(std::round(_fps_actual)))});
+  buf.put(Pos{0, _height - 1}, std::to_string(static_cast<int>(std::round(_fps_actual))), style);
 
   if (_cfg.color) {
     style.fg = _cfg.style.button;
   }
-  _win.buf.put(Pos{_width - 3, _height - 1}, Cell{1, style, "[X]"});
+  buf.put(Pos{_width - _ui_close.cols(), _height - 1}, _ui_close, style);
 }
 
 void App::draw_ui_bottom() {
+  auto& buf = _layers[Layer::Ui].buf;
   auto style = _cfg.color ? Style{Style::Bit_24, 0, _cfg.style.ui, _cfg.style.ui_bg} : _style_default;
   if (_cfg.color) {
     style.attr |= Style::Bold;
@@ -652,101 +751,221 @@ void App::draw_ui_bottom() {
     style.attr |= Style::Reverse;
   }
 
-  _win.buf.put(Pos{0, 0}, Cell{1, style, std::string(_width, ' ')});
+  buf.put(Pos{0, 0}, _ui_fill, style);
 
   {
     auto style_score = style;
     style_score.fg.a(255);
 
     auto score = std::to_string(_score);
-    _win.buf.put(Pos{0, 0}, Cell{1, style_score, score});
+    buf.put(Pos{0, 0}, score, style_score);
 
     auto high_score = std::to_string(_high_score);
-    _win.buf.put(Pos{_width - high_score.size(), 0}, Cell{1, style_score, high_score});
+    buf.put(Pos{_width - high_score.size(), 0}, high_score, style_score);
   }
 
   if (!_playing) {
-    auto pos = Pos((_width / 2) - (_ui_start.size() / 2), 0);
-    _win.buf.put(pos, Cell{1, style, _ui_start});
+    auto pos = Pos((_width / 2) - (_ui_start.cols() / 2), 0);
+    buf.put(pos, _ui_start, style);
   }
   else if (_score != 0 && _score > _high_score) {
-    auto pos = Pos((_width / 2) - (_ui_high_score.size() / 2), 0);
-    _win.buf.put(pos, Cell{1, style, _ui_high_score});
+    auto pos = Pos((_width / 2) - (_ui_high_score.cols() / 2), 0);
+    buf.put(pos, _ui_high_score, style);
   }
 }
 
 void App::draw_box() {
-  draw_vertical(_box);
+  draw_vertical(_layers[Layer::Actors].buf, _box);
 }
 
 void App::draw_trail(double const i) {
-  draw_vertical(_trail[i], [&](auto& style) {
+  draw_vertical(_layers[Layer::World].buf, _trail[i], [&](auto& style) {
     if (_cfg.color) {
-      style.fg = _cfg.style.trail;
-      style.fg.a(255 * (i / _trail.size()));
+      style.fg = _palette.trail[trail_alpha(i)];
     }
   });
 }
 
+bool App::trail_shown(std::size_t const i) const {
+  // a column is drawn when it sits below the one after it, the last column
+  // goes with the one before it
+  if (i + 1 < _trail.size()) {
+    return _trail[i].position.y < _trail[i + 1].position.y;
+  }
+  return _trail[_trail.size() - 2].position.y < _trail.back().position.y;
+}
+
 void App::draw_trails() {
-  for (std::size_t i = 0; i < _trail.size() - 1; ++i) {
-    if (_trail[i].position.y < _trail[i + 1].position.y) {
-      draw_trail(i);
+  for (std::size_t i = 0; i < _trail.size(); ++i) {
+    if (trail_shown(i)) {
+      draw_trail(static_cast<double>(i));
     }
   }
-  if (_trail[_trail.size() - 2].position.y < _trail.back().position.y) {
-    draw_trail(_trail.size() - 1);
-  }
 }
 
 void App::draw_goals() {
   for (auto const& goal : _goals) {
-    auto const& fg = goal.state == Goal::State::Null ? _cfg.style.goal : (goal.state == Goal::State::Pass ? _cfg.style.goal_pass : (_cfg.style.goal_miss));
+    // goals can cross the trail, so they fade with alpha rather than a ramp
+    auto const& fg = goal.state == Goal::State::Null ? _palette.goal : (goal.state == Goal::State::Pass ? _palette.goal_pass : _palette.goal_miss);
     for (auto const& sprite : goal.sprites) {
-      draw_vertical(sprite, [&](auto& style) {
-        style.fg = fg;
-        if (goal.state == Goal::State::Pass && sprite.position.x + sprite.size.x < _box.position.x) {
-          style.fg.a(255 * ((sprite.position.x + sprite.size.x) / _box.position.x));
-        }
-        else if (sprite.position.x > _box.position.x) {
-          style.fg.a(255 * ((sprite.position.x - _width) / (_box.position.x - _width)));
-        }
+      // resolved up front, a lambda capturing one reference fits in the
+      // std::function without a heap allocation
+      auto color = fg;
+      if (_fade) {
+        color.a(goal_alpha(goal, sprite));
+      }
+      draw_vertical(_layers[Layer::World].buf, sprite, [&color](auto& style) {
+        style.fg = color;
       });
     }
   }
 }
 
 void App::draw_prompt() {
+  auto& buf = _layers[Layer::Prompt].buf;
   if (_readline._typing) {
     auto style = _cfg.color ? Style{Style::Bit_24, 0, _cfg.style.prompt, _cfg.style.bg} : Style{Style::Default, 0, {}, {}};
 
     if (_readline._mode == OB::Readline::Mode::autocomplete_init || _readline._mode == OB::Readline::Mode::autocomplete) {
-      _win.buf.cursor(Pos(0, 1));
-      _win.buf.put(Cell{1, style, std::string(_width, ' ')});
-      _win.buf.cursor(Pos(0, 1));
-      _win.buf.put(Cell{1, style, _readline._autocomplete._lhs});
-      _win.buf.put(Cell{1, style, _readline._autocomplete._text});
-      _win.buf.cursor(Pos(_width - 1, 1));
-      _win.buf.put(Cell{1, style, _readline._autocomplete._rhs});
+      buf.cursor(Pos(0, 1));
+      buf.put(_ui_fill, style);
+      buf.cursor(Pos(0, 1));
+      buf.put(_readline._autocomplete._lhs, style);
+      buf.put(_readline._autocomplete._text, style);
+      buf.cursor(Pos(_width - 1, 1));
+      buf.put(_readline._autocomplete._rhs, style);
       for (std::size_t i = 0; i < _readline._autocomplete._hls; ++i) {
-        _win.buf.col(Pos(_readline._autocomplete._hli + i, 1)).style.attr |= Style::Reverse;
+        buf.col(Pos(_readline._autocomplete._hli + i, 1)).style.attr |= Style::Reverse;
       }
     }
 
     _readline.refresh();
-    _win.buf.cursor(Pos(0, 0));
-    _win.buf.put(Cell{1, style, std::string(_width, ' ')});
-    _win.buf.cursor(Pos(0, 0));
-    _win.buf.put(Cell{1, style, _readline._prompt.lhs});
-    _win.buf.put(Cell{1, style, _readline._input.fmt});
-    _win.buf.put(Cell{1, style, _readline._prompt.rhs});
-    _win.buf.col(Pos(_readline._input.cur + 1, 0)).style.attr |= Style::Reverse;
+    buf.cursor(Pos(0, 0));
+    buf.put(_ui_fill, style);
+    buf.cursor(Pos(0, 0));
+    buf.put(_readline._prompt.lhs, style);
+    buf.put(_readline._input.fmt.str(), style);
+    buf.put(_readline._prompt.rhs, style);
+    buf.col(Pos(_readline._input.cur + 1, 0)).style.attr |= Style::Reverse;
   }
 }
 
+void App::stats() {
+  // built in place, _stats keeps its capacity from frame to frame
+  _stats.clear();
+  if (!_show_stats) {return;}
+
+  auto const field = [&](std::string_view const name, auto const val, std::string_view const unit = {}) {
+    char num[24];
+    auto const res = std::to_chars(std::begin(num), std::end(num), val);
+    _stats += " ";
+    _stats += name;
+    _stats += " ";
+    _stats.append(num, static_cast<std::size_t>(res.ptr - num));
+    _stats += unit;
+  };
+  field("bytes", _win.bsize.load());
+  field("writes", _win.wcount.load());
+  field("dropped", _win.dropped);
+  field("merged", _win.merged);
+  field("depth", _win.depth == Style::Bit_24 ? 24 : _win.depth == Style::Bit_8 ? 8 : 4);
+  // time the tick thread spent drawing and handing off the last frame
+  field("render", std::chrono::duration_cast<std::chrono::microseconds>(_render_time).count(), "us");
+  if (_win.threaded) {
+    field("queue", _win.queue.pending() ? 1 : 0);
+  }
+  if (_win.scroll) {
+    field("scrolled", _win.scrolled.load());
+  }
+  if (_adaptive) {
+    field("quality", _quality);
+    field("load", static_cast<int>(std::round(_load * 100)), "%");
+    field("budget", static_cast<int>(std::round(_bytes / (_budget * std::chrono::duration<double>(_tick).count()) * 100)), "%");
+  }
+  _stats += " ";
+}
+
+void App::draw_stats() {
+  if (!_show_stats) {return;}
+
+  auto style = _cfg.color ? Style{Style::Bit_24, 0, _cfg.style.ui, _cfg.style.ui_bg} : _style_default;
+  if (!_cfg.color) {
+    style.attr |= Style::Reverse;
+  }
+
+  _layers[Layer::Ui].buf.put(Pos{0, _height - 2}, _stats, style);
+}
+
 void App::render() {
+  auto const begin = Clock::now();
   draw();
   _win.render();
+  _render_time = Clock::now() - begin;
+}
+
+void App::adapt() {
+  auto const now = Clock::now();
+  auto const tick = std::chrono::duration<double>(_tick).count();
+
+  // bytes per frame over the rate the terminal drains them, as a share of the tick
+  _load = (_load * 0.8) + (0.2 * std::chrono::duration<double>(_win.wtime.load()).count() / tick);
+  // bytes of the last frame against the share of the budget one tick gets,
+  // a fast terminal can take a frame the link behind it can not, and the
+  // frame rate levels relieve it by giving each frame a longer tick
+  _bytes = (_bytes * 0.8) + (0.2 * static_cast<double>(_win.bsize.load()));
+  auto const budget = _budget * tick;
+  // frames the output had to skip since the last tick
+  auto const dropped = _win.dropped - _trend_dropped;
+  _trend_dropped = _win.dropped;
+  // update and render ran past the tick
+  auto const overrun = now - _tick_end > _tick;
+
+  int trend {0};
+  if (_load > 0.5 || _bytes > budget || dropped > 0 || overrun) {
+    trend = -1;
+  }
+  else if (_load < 0.2 && _bytes < budget * 0.5) {
+    trend = 1;
+  }
+
+  if (trend != _trend) {
+    _trend = trend;
+    _trend_begin = now;
+    return;
+  }
+
+  // step down quickly, step up only after a long quiet stretch
+  if (_trend < 0 && now - _trend_begin >= 500ms && _quality + 1 < _quality_levels) {
+    quality(_quality + 1);
+    _trend_begin = now;
+  }
+  else if (_trend > 0 && now - _trend_begin >= 5s && _quality > 0) {
+    quality(_quality - 1);
+    _trend_begin = now;
+  }
+}
+
+void App::quality(std::size_t const level) {
+  _quality = level;
+
+  // level 1 drops the alpha fades, their colours change every frame
+  if (_fade != (level < 1)) {
+    _fade = level < 1;
+  }
+
+  // levels 2 and 3 step down to the 256 and then the 16 colour palette
+  auto depth = _depth;
+  if (level >= 2) {depth = std::min(depth, static_cast<std::uint8_t>(Style::Bit_8));}
+  if (level >= 3) {depth = std::min(depth, static_cast<std::uint8_t>(Style::Bit_4));}
+  if (depth != _win.depth) {
+    _win.depth = depth;
+    // cells on screen were encoded at the old depth
+    _win.refresh();
+  }
+
+  // levels 4 and 5 halve and then third the frame rate
+  auto const fps = _cfg.fps / (level >= 5 ? 3.0 : level >= 4 ? 2.0 : 1.0);
+  _tick = Tick(static_cast<long int>(1000000000.0 / fps));
 }
 
 void App::keymap_init() {
@@ -784,6 +1003,11 @@ void App::keymap_init() {
 
   _keymap['c'] = [&]() {
     _cfg.color = !_cfg.color;
+    redraw();
+  };
+
+  _keymap['i'] = [&]() {
+    _show_stats = !_show_stats;
   };
 
   _keymap['s'] = [&]() {
@@ -830,6 +1054,8 @@ void App::readline_init() {
 }
 
 void App::game_init() {
+  redraw();
+
   // game state
   _playing = false;
   _timescale = 1.0;
@@ -864,6 +1090,9 @@ void App::game_init() {
   _goals.clear();
   add_goal(_width, random_range(_window_height + 1ul, _height - (_window_height * 2ul) - 1ul, _state.seed++));
 
+  // headless runs drive the ticks themselves
+  if (_headless) {return;}
+
   // timers
   _timer.cancel();
   _tick_end = Clock::now();
@@ -871,12 +1100,34 @@ void App::game_init() {
   await_tick();
 }
 
-void App::run() {
-  await_signal();
+void App::palette_init() {
+  auto const& theme = _cfg.style;
+  _palette.box = theme.box;
+  _palette.goal = theme.goal;
+  _palette.goal_pass = theme.goal_pass;
+  _palette.goal_miss = theme.goal_miss;
+  // the same rounding as compositing the faded trail over the bg
+  OB::Prism::RGBA const trail {theme.trail};
+  for (std::size_t alpha = 0; alpha < _palette.trail.size(); ++alpha) {
+    OB::Prism::lerp(&_palette.trail[alpha], &theme.bg, &trail, 1, static_cast<std::uint8_t>(alpha));
+  }
+}
 
-  auto const is_term = Term::is_term(STDOUT_FILENO);
-  if (!is_term) {throw std::runtime_error("stdout is not a tty");}
+std::uint8_t App::colour_depth(std::string const& val) {
+  if (val == "24") {return Style::Bit_24;}
+  if (val == "8") {return Style::Bit_8;}
+  if (val == "4") {return Style::Bit_4;}
+  if (val != "auto") {throw std::runtime_error("invalid colour depth '" + val + "'");}
+
+  // headless output must not depend on the environment it was run from
+  if (_headless) {return Style::Bit_24;}
 
+  if (OB::Term::is_colorterm()) {return Style::Bit_24;}
+  if (OB::Term::env_var("TERM").find("256color") != std::string::npos) {return Style::Bit_8;}
+  return Style::Bit_4;
+}
+
+void App::window_init() {
   if (_cfg.color) {
     _style_base = Style{Style::Bit_24, Style::Null, _cfg.style.bg, _cfg.style.bg};
   }
@@ -884,10 +1135,51 @@ void App::run() {
     _style_base = Style{Style::Default, Style::Null, {}, {}};
   }
   _win.style_base = _style_base;
+  palette_init();
+  _depth = colour_depth(_pg.get<std::string>("colour-depth"));
+  _win.depth = _depth;
+
+  _win.diff_full = _pg.find("diff-full");
+  _win.scroll = _pg.find("scroll");
+
+  auto threads = _pg.get<std::size_t>("threads");
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if (threads > 1) {
+    _win.pool = std::make_unique<OB::Pool>(threads);
+  }
+}
+
+void App::run() {
+  if (_pg.find("headless")) {
+    run_headless();
+    return;
+  }
+
+  await_signal();
+
+  auto const is_term = Term::is_term(STDOUT_FILENO);
+  if (!is_term) {throw std::runtime_error("stdout is not a tty");}
+
+  window_init();
+  _win.sync = _pg.find("sync");
+  _adaptive = _pg.find("adaptive");
+  _budget = static_cast<double>(_pg.get<std::size_t>("budget"));
+  if (_budget < 1) {throw std::runtime_error("invalid budget, the minimum is 1");}
+  _win.threaded = _pg.find("threaded");
+  if (!_win.threaded) {
+    _win.output(_io);
+  }
 
   _term_mode = std::make_unique<OB::Term::Mode>();
   screen_init();
   on_winch();
+  auto const record = _pg.get<std::string>("record");
+  if (!record.empty()) {
+    _win.record = std::make_unique<Asciicast>(record, _width, _height);
+    _win.record->output(aec::cursor_hide);
+  }
   keymap_init();
   readline_init();
   await_read();
@@ -896,3 +1188,107 @@ void App::run() {
   _io.run();
   screen_deinit();
 }
+
+void App::advance(double const dt) {
+  _time += _tick;
+  _ftime += _tick;
+  while (_ftime >= _timestep) {
+    _ftime -= _timestep;
+    update(dt);
+    ++_frame;
+  }
+}
+
+void App::run_headless() {
+  _headless = true;
+
+  auto const size = _pg.get<std::string>("size");
+  auto const delim = size.find('x');
+  try {
+    if (delim == std::string::npos) {throw std::invalid_argument("size");}
+    _width = std::stoul(size.substr(0, delim));
+    _height = std::stoul(size.substr(delim + 1));
+  }
+  catch (std::logic_error const&) {
+    throw std::runtime_error("invalid size '" + size + "'");
+  }
+  if (_width < width_min || _height < height_min) {
+    throw std::runtime_error("invalid size '" + size + "', the minimum is " + std::to_string(width_min) + "x" + std::to_string(height_min));
+  }
+  _fixed_size = true;
+
+  auto const frames = _pg.get<std::size_t>("frames");
+
+  auto const format = _pg.get<std::string>("format");
+  if (format != "text" && format != "ansi") {throw std::runtime_error("invalid format '" + format + "'");}
+  auto const ansi = format == "ansi";
+
+  // without an output file frames only go to the in-memory buffer
+  std::ofstream file;
+  auto const output = _pg.get<std::string>("output");
+  if (!output.empty()) {
+    file.open(output, std::ios::binary | std::ios::trunc);
+    if (!file) {throw std::runtime_error("could not open '" + output + "'");}
+  }
+
+  window_init();
+  _win.size = {_width, _height};
+  _win.winch();
+
+  _state = {};
+  if (_pg.find("seed")) {
+    _state.seed = _pg.get<unsigned int>("seed");
+  }
+  game_init();
+
+  // game time advances a fixed tick per frame, independent of how long the frame took
+  double const dt = std::chrono::duration<double>(_timestep).count();
+  _fps_actual = _cfg.fps;
+  Tick total {0ns};
+  Tick fastest {Tick::max()};
+  Tick slowest {0ns};
+  Tick drawing {0ns};
+  std::size_t bytes {0};
+  std::size_t blended {0};
+
+  for (std::size_t i = 0; i < frames; ++i) {
+    auto const begin = Clock::now();
+
+    advance(dt);
+
+    auto const draw_begin = Clock::now();
+    draw();
+    drawing += std::chrono::duration_cast<Tick>(Clock::now() - draw_begin);
+    blended += _win.buf.blended();
+    if (file.is_open()) {
+      _win.render_file(file, ansi);
+    }
+    else {
+      _win.render_buffer();
+    }
+
+    auto const elapsed = std::chrono::duration_cast<Tick>(Clock::now() - begin);
+    total += elapsed;
+    fastest = std::min(fastest, elapsed);
+    slowest = std::max(slowest, elapsed);
+    bytes += _win.bsize;
+  }
+
+  auto const ms = [](Tick const val) {
+    return std::chrono::duration<double, std::milli>(val).count();
+  };
+
+  std::cout
+  << std::fixed << std::setprecision(3)
+  << "frames " << frames << "\n"
+  << "size " << _width << "x" << _height << "\n"
+  << "time " << ms(total) << "ms\n"
+  << "frame avg " << (frames ? ms(total) / static_cast<double>(frames) : 0.0) << "ms"
+  << " min " << (frames ? ms(fastest) : 0.0) << "ms"
+  << " max " << ms(slowest) << "ms\n"
+  << "bytes " << bytes << "\n"
+  << "draw " << ms(drawing) << "ms"
+  << " blended " << blended << " cells"
+  << " " << (drawing.count() ? static_cast<double>(blended) / std::chrono::duration<double>(drawing).count() / 1e6 : 0.0) << "M cells/s\n"
+  << std::flush;
+}
@@ -106,8 +106,11 @@ namespace fs = std::filesystem;
 namespace asio = boost::asio;
 
 class App {
+  // drives the frame loop in test/alloc.cc
+  friend struct App_test;
+
 public:
-  App(OB::Parg const& pg);
+  App(OB::Parg& pg);
   ~App();
 
   void run();
@@ -115,6 +118,28 @@ public:
 private:
   using Position = Vec2n<double>;
 
+  // 64-bit FNV-1a over the values a layer is drawn from, built in place each
+  // frame so comparing keys does not allocate
+  class Layer_key {
+  public:
+    Layer_key& operator()(std::uint64_t val) {
+      for (std::size_t i = 0; i < sizeof(val); ++i, val >>= 8) {
+        _value = (_value ^ (val & 0xff)) * 1099511628211ull;
+      }
+      return *this;
+    }
+    Layer_key& operator()(std::string_view const str) {
+      for (auto const c : str) {
+        _value = (_value ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+      }
+      return (*this)(str.size());
+    }
+    std::uint64_t value() const {return _value;}
+
+  private:
+    std::uint64_t _value {14695981039346656037ull};
+  };
+
   struct Object {
     Size size {0, 0};
     Position position {0, 0};
@@ -170,11 +195,17 @@ private:
   Record _record;
   Record _record_best;
 
-  OB::Parg const& _pg;
+  OB::Parg& _pg;
 
   void quit();
   void screen_init();
   void screen_deinit();
+  std::uint8_t colour_depth(std::string const& val);
+  void window_init();
+  void palette_init();
+  void run_headless();
+  // one headless tick of game time, in fixed steps of dt
+  void advance(double const dt);
   void await_signal();
   void await_tick();
   void on_winch();
@@ -206,9 +237,18 @@ private:
   void increase_velocity();
 
   void render();
+  void adapt();
+  void quality(std::size_t const level);
   void draw();
-  void draw_vertical(Object const& obj, std::function<void(Style&)> const& fn = {});
-  void draw_horizontal(Object const& obj, std::function<void(Style&)> const& fn = {});
+  void redraw();
+  void layer_key(std::size_t const layer, Layer_key const& key);
+  static void key_bar(Layer_key& key, Object const& obj);
+  bool trail_shown(std::size_t const i) const;
+  std::uint8_t trail_alpha(double const i) const;
+  std::uint8_t goal_alpha(Goal const& goal, Object const& sprite) const;
+  void stats();
+  void draw_vertical(Buffer& buf, Object const& obj, std::function<void(Style&)> const& fn = {});
+  void draw_horizontal(Buffer& buf, Object const& obj, std::function<void(Style&)> const& fn = {});
   void draw_game();
   void draw_ui();
   void draw_ui_top();
@@ -218,12 +258,16 @@ private:
   void draw_trails();
   void draw_goals();
   void draw_prompt();
+  void draw_stats();
 
   Box _box;
   std::vector<Object> _trail;
   Goals _goals;
   bool _playing {false};
   bool _mouse_down {false};
+  bool _show_stats {false};
+  // the stats line of the frame being drawn, see draw
+  std::string _stats;
   std::size_t _frame {0};
   std::size_t _mouse_frames {0};
   double _distance {0.0};
@@ -237,37 +281,58 @@ private:
   std::size_t _window_height {0};
   std::size_t _goal_width {0};
 
-  std::string _ui_name {"FLOATYBOX v0.1.0"};
-  std::string _ui_start {"Click or <Space> to float!"};
-  std::string _ui_high_score {"New High Score!"};
+  // constant ui text, segmented once
+  Prepared_text _ui_name {"FLOATYBOX v0.1.0"};
+  Prepared_text _ui_start {"Click or <Space> to float!"};
+  Prepared_text _ui_high_score {"New High Score!"};
+  Prepared_text _ui_close {"[X]"};
+  // a row of spaces the width of the screen, remade when the width changes
+  Prepared_text _ui_fill;
 
   struct Config {
     double fps {30.0};
     bool color {true};
 
     struct Style {
-      OB::Prism::RGBA bg        {OB::Prism::Hex("1b1e24")};
-      OB::Prism::RGBA prompt    {OB::Prism::Hex("abb2bf")};
-      OB::Prism::RGBA ui        {OB::Prism::Hex("abb2bf")};
-      OB::Prism::RGBA ui_bg     {OB::Prism::Hex("3e4452")};
-      OB::Prism::RGBA button    {OB::Prism::Hex("abb2bf")};
-      OB::Prism::HSLA box       {OB::Prism::Hex("df6c3e")};
-      OB::Prism::HSLA trail     {OB::Prism::Hex("abb2bf")};
-      OB::Prism::HSLA goal      {OB::Prism::Hex("61afef")};
-      OB::Prism::HSLA goal_pass {OB::Prism::Hex("e5c07b")};
-      OB::Prism::HSLA goal_miss {OB::Prism::Hex("d30946")};
+      OB::Prism::RGBA bg        {OB::Prism::RGBA::hex("1b1e24")};
+      OB::Prism::RGBA prompt    {OB::Prism::RGBA::hex("abb2bf")};
+      OB::Prism::RGBA ui        {OB::Prism::RGBA::hex("abb2bf")};
+      OB::Prism::RGBA ui_bg     {OB::Prism::RGBA::hex("3e4452")};
+      OB::Prism::RGBA button    {OB::Prism::RGBA::hex("abb2bf")};
+      OB::Prism::HSLA box       {OB::Prism::RGBA::hex("df6c3e")};
+      OB::Prism::HSLA trail     {OB::Prism::RGBA::hex("abb2bf")};
+      OB::Prism::HSLA goal      {OB::Prism::RGBA::hex("61afef")};
+      OB::Prism::HSLA goal_pass {OB::Prism::RGBA::hex("e5c07b")};
+      OB::Prism::HSLA goal_miss {OB::Prism::RGBA::hex("d30946")};
     } style;
   } _cfg;
 
+  // the theme resolved to rgba once, by palette_init
+  struct Palette {
+    OB::Prism::RGBA box;
+    OB::Prism::RGBA goal;
+    OB::Prism::RGBA goal_pass;
+    OB::Prism::RGBA goal_miss;
+    // the trail at every alpha, already composited over the bg, it is always
+    // drawn first onto an empty world layer so only the bg is underneath
+    std::array<OB::Prism::RGBA, 256> trail;
+  } _palette;
+
   Style _style_base {Style::Bit_24, Style::Null, _cfg.style.bg, _cfg.style.bg};
   Style _style_default {Style::Default, Style::Null, {}, {}};
 
-  std::array<std::string, 8> _bar_vertical {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
-  std::array<std::string, 8> _bar_horizontal {"▏", "▎", "▍", "▌", "▋", "▊", "▉", "█"};
+  std::array<Glyph, 8> _bar_vertical {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+  std::array<Glyph, 8> _bar_horizontal {"▏", "▎", "▍", "▌", "▋", "▊", "▉", "█"};
 
   bool _fixed_size {false};
+  // no terminal, a fixed size and a set number of frames, see run_headless
+  bool _headless {false};
   std::size_t _width {40};
   std::size_t _height {40};
+  // smallest playfield, two trail columns left of the box and a goal window
+  // with room above and below its spawn range
+  static constexpr std::size_t width_min {12};
+  static constexpr std::size_t height_min {17};
 
   asio::io_context _io {1};
   Belle::Signal _sig {_io};
@@ -286,6 +351,43 @@ private:
   std::chrono::time_point<Clock> _tick_begin {(Clock::time_point::min)()};
   std::chrono::time_point<Clock> _tick_end {(Clock::time_point::min)()};
   double _fps_actual {0.0};
+  Tick _render_time {0ns};
+
+  // adaptive quality, gives up alpha fades, colour depth and then frame rate
+  // while the terminal can not keep up, and takes them back once it can
+  static constexpr std::size_t _quality_levels {6};
+  bool _adaptive {false};
+  std::size_t _quality {0};
+  // requested colour depth, the most the controller steps back up to
+  std::uint8_t _depth {Style::Bit_24};
+  bool _fade {true};
+  // smoothed share of the tick spent waiting on the terminal
+  double _load {0.0};
+  // bytes per second the output should stay under, and the smoothed bytes
+  // of each frame held against its share of it
+  double _budget {1048576.0};
+  double _bytes {0.0};
+  // -1 under pressure, 1 with headroom, and when that started
+  int _trend {0};
+  std::chrono::time_point<Clock> _trend_begin;
+  std::size_t _trend_dropped {0};
+
+  // cached buffers composited in order over the base of each frame, a layer is
+  // only drawn again when what it shows changed
+  struct Layer {
+    enum {
+      World = 0,
+      Actors,
+      Ui,
+      Prompt,
+      Count,
+    };
+    Buffer buf;
+    // hash of what the layer was last drawn from
+    std::uint64_t key {0};
+    bool dirty {true};
+  };
+  std::array<Layer, Layer::Count> _layers;
 
   std::unique_ptr<OB::Term::Mode> _term_mode;
   Window _win;
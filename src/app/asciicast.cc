@@ -0,0 +1,174 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "app/asciicast.hh"
+
+#include "ob/term.hh"
+
+#include <ctime>
+#include <cstdio>
+
+#include <utility>
+#include <stdexcept>
+
+static void json_string(std::string& str, std::string_view const val) {
+  str += '"';
+  for (auto const c : val) {
+    switch (c) {
+      case '"': {str += "\\\""; break;}
+      case '\\': {str += "\\\\"; break;}
+      case '\n': {str += "\\n"; break;}
+      case '\r': {str += "\\r"; break;}
+      case '\t': {str += "\\t"; break;}
+      default: {
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[7];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(c)));
+          str += buf;
+        }
+        else {
+          // utf-8 passes through, frames are only ever split on whole glyphs
+          str += c;
+        }
+        break;
+      }
+    }
+  }
+  str += '"';
+}
+
+Asciicast::Asciicast(std::string const& path, std::size_t const width, std::size_t const height) :
+  _file {path, std::ios::binary | std::ios::trunc},
+  _begin {std::chrono::steady_clock::now()},
+  _width {width},
+  _height {height} {
+  if (!_file) {throw std::runtime_error("could not open '" + path + "'");}
+
+  std::string header;
+  header += "{\"version\": 2, \"width\": " + std::to_string(width);
+  header += ", \"height\": " + std::to_string(height);
+  header += ", \"timestamp\": " + std::to_string(static_cast<long long>(std::time(nullptr)));
+  header += ", \"env\": {\"TERM\": ";
+  json_string(header, OB::Term::env_var("TERM"));
+  header += ", \"SHELL\": ";
+  json_string(header, OB::Term::env_var("SHELL"));
+  header += "}}\n";
+  _file << header << std::flush;
+  if (!_file) {throw std::runtime_error("could not write '" + path + "'");}
+
+  _thread = std::thread([&]() {run();});
+}
+
+Asciicast::~Asciicast() {
+  {
+    std::lock_guard<std::mutex> lock {_mutex};
+    _stop = true;
+  }
+  _cond.notify_one();
+  _thread.join();
+}
+
+void Asciicast::output(std::string_view const str) {
+  if (str.empty()) {return;}
+  push('o', str);
+}
+
+void Asciicast::resize(std::size_t const width, std::size_t const height) {
+  std::string size {std::to_string(width) + "x" + std::to_string(height)};
+  {
+    std::lock_guard<std::mutex> lock {_mutex};
+    if (width == _width && height == _height) {return;}
+    _width = width;
+    _height = height;
+  }
+  push('r', size);
+}
+
+void Asciicast::push(char const type, std::string_view const data) {
+  if (_failed) {throw std::runtime_error("record write failed");}
+  {
+    // timestamps are taken under the lock so events stay in time order
+    // across threads
+    std::lock_guard<std::mutex> lock {_mutex};
+    _pending.push_back(Event{std::chrono::steady_clock::now() - _begin, type, std::string(data)});
+  }
+  _cond.notify_one();
+}
+
+void Asciicast::run() {
+  std::vector<Event> events;
+  std::string str;
+
+  for (;;) {
+    bool stop {false};
+    {
+      std::unique_lock<std::mutex> lock {_mutex};
+      _cond.wait(lock, [&]() {return _stop || !_pending.empty();});
+      std::swap(events, _pending);
+      stop = _stop;
+    }
+
+    for (auto const& event : events) {
+      encode(str, event);
+    }
+    events.clear();
+
+    if (!str.empty() && !_failed) {
+      _file << str << std::flush;
+      if (!_file) {_failed = true;}
+      str.clear();
+    }
+
+    if (stop) {break;}
+  }
+}
+
+void Asciicast::encode(std::string& str, Event const& event) {
+  char time[32];
+  std::snprintf(time, sizeof(time), "[%.6f, \"%c\", ", std::chrono::duration<double>(event.time).count(), event.type);
+  str += time;
+  json_string(str, event.data);
+  str += "]\n";
+}
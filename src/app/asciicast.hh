@@ -0,0 +1,97 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ASCIICAST_HH
+#define ASCIICAST_HH
+
+#include <chrono>
+#include <cstddef>
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <string_view>
+#include <condition_variable>
+
+// asciicast v2 recorder, events are timestamped by the caller's thread and
+// encoded and written to disk by a background thread
+class Asciicast {
+public:
+  Asciicast(std::string const& path, std::size_t const width, std::size_t const height);
+  ~Asciicast();
+
+  // bytes sent to the terminal
+  void output(std::string_view const str);
+  // terminal size change, ignored if the size did not change
+  void resize(std::size_t const width, std::size_t const height);
+
+private:
+  struct Event {
+    std::chrono::steady_clock::duration time;
+    char type;
+    std::string data;
+  };
+
+  void push(char const type, std::string_view const data);
+  void run();
+  void encode(std::string& str, Event const& event);
+
+  std::ofstream _file;
+  std::chrono::steady_clock::time_point _begin;
+  std::size_t _width;
+  std::size_t _height;
+  std::mutex _mutex;
+  std::condition_variable _cond;
+  // filled by the callers, swapped out whole by the writer
+  std::vector<Event> _pending;
+  bool _stop {false};
+  std::atomic<bool> _failed {false};
+  std::thread _thread;
+}; // class Asciicast
+
+#endif // ASCIICAST_HH
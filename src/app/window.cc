@@ -50,17 +50,30 @@ SOFTWARE.
 #include "ob/prism.hh"
 #include "ob/timer.hh"
 
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 #include <cmath>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
+#include <array>
 #include <tuple>
 #include <deque>
 #include <regex>
 #include <chrono>
 #include <limits>
+#include <mutex>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <thread>
@@ -70,108 +83,374 @@ SOFTWARE.
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <algorithm>
 #include <functional>
 #include <unordered_map>
 
+// graphemes too long to store inline, kept for the lifetime of the program
+struct Glyph_table {
+  std::mutex mtx;
+  std::deque<std::string> value;
+  std::unordered_map<std::string_view, std::uint32_t> index;
+};
+
+static Glyph_table& glyph_table() {
+  static Glyph_table table;
+  return table;
+}
+
+static Glyph const glyph_space {" "};
+
+Glyph::Glyph(char const* str) : Glyph(std::string_view(str)) {
+}
+
+Glyph::Glyph(std::string const& str) : Glyph(std::string_view(str)) {
+}
+
+Glyph::Glyph(std::string_view const str) {
+  // skip the grapheme segmenter for plain ascii
+  if (str.size() == 1 && static_cast<unsigned char>(str[0]) < 0x80) {
+    assign(str, 1);
+  }
+  else {
+    assign(str, OB::Text::View(str).cols());
+  }
+}
+
+Glyph::Glyph(std::string_view const str, std::size_t const cols) {
+  assign(str, cols);
+}
+
+void Glyph::assign(std::string_view const str, std::size_t const cols) {
+  std::memset(_bytes, 0, capacity);
+  auto const meta_cols = static_cast<std::uint8_t>((std::min<std::size_t>(cols, 3) << Cols_shift) & Cols_mask);
+
+  if (str.size() <= capacity) {
+    std::memcpy(_bytes, str.data(), str.size());
+    _meta = static_cast<std::uint8_t>(str.size() | meta_cols);
+    return;
+  }
+
+  auto& table = glyph_table();
+  std::lock_guard<std::mutex> lock {table.mtx};
+  std::uint32_t id {0};
+  if (auto it = table.index.find(str); it != table.index.end()) {
+    id = it->second;
+  }
+  else {
+    id = static_cast<std::uint32_t>(table.value.size());
+    table.index.emplace(table.value.emplace_back(str), id);
+  }
+  std::memcpy(_bytes, &id, sizeof(id));
+  _meta = static_cast<std::uint8_t>(Interned | meta_cols);
+}
+
+std::string_view Glyph::str() const {
+  if (_meta & Interned) {
+    std::uint32_t id {0};
+    std::memcpy(&id, _bytes, sizeof(id));
+    auto& table = glyph_table();
+    std::lock_guard<std::mutex> lock {table.mtx};
+    return table.value[id];
+  }
+  return std::string_view(_bytes, _meta & Size_mask);
+}
+
+std::size_t Glyph::size() const {
+  if (_meta & Interned) {
+    return str().size();
+  }
+  return _meta & Size_mask;
+}
+
+std::size_t Glyph::cols() const {
+  return static_cast<std::size_t>((_meta & Cols_mask) >> Cols_shift);
+}
+
+bool Glyph::empty() const {
+  return size() == 0;
+}
+
+Prepared_text::Prepared_text(std::string_view const str) :
+  _str {str} {
+  OB::Text::View view {_str};
+  _glyphs.reserve(view.size());
+  for (auto const& e : view) {
+    _glyphs.emplace_back(e.str, e.cols);
+  }
+  _cols = view.cols();
+}
+
+std::string const& Prepared_text::str() const {
+  return _str;
+}
+
+std::vector<Glyph> const& Prepared_text::glyphs() const {
+  return _glyphs;
+}
+
+std::size_t Prepared_text::cols() const {
+  return _cols;
+}
+
 Buffer::Buffer(Size const size, Cell const& cell) {
   this->size(size, cell);
 }
 
+// source over for the fg and bg of a run of cells, each pair is gathered
+// next to the colours going over it and the run is composited at once by
+// OB::Prism::blend, results go back to the cells on flush
+class Over {
+public:
+  void add(Style& dst, Style const& src) {
+    _dst[_size] = &dst;
+    _val[_size * 2] = dst.fg;
+    _val[_size * 2 + 1] = dst.bg;
+    _src[_size * 2] = src.fg;
+    _src[_size * 2 + 1] = src.bg;
+    if (++_size == capacity) {
+      flush();
+    }
+  }
+
+  void flush() {
+    OB::Prism::blend(_val.data(), _src.data(), _size * 2);
+    for (std::size_t i = 0; i < _size; ++i) {
+      _dst[i]->fg = _val[i * 2];
+      _dst[i]->bg = _val[i * 2 + 1];
+    }
+    _size = 0;
+  }
+
+private:
+  // cells, a cell must not be added twice before a flush
+  static constexpr std::size_t capacity {32};
+  std::array<Style*, capacity> _dst;
+  std::array<OB::Prism::RGBA, capacity * 2> _val;
+  std::array<OB::Prism::RGBA, capacity * 2> _src;
+  std::size_t _size {0};
+}; // class Over
+
+// one batch per thread, kept so its arrays are not set up again on every
+// call, each caller flushes before returning
+static Over& over_batch() {
+  static thread_local Over over;
+  return over;
+}
+
 void Buffer::operator()(Pos const pos, Cell const& cell) {
   // return on out of bounds
   if (pos.x > _size.x - 1 || pos.y > _size.y - 1) {return;}
   cursor(std::move(pos));
-  operator()(cell);
+  // bounds already checked, skip the checked accessor
+  auto const spos = Pos(pos.x, _size.y - pos.y - 1);
+  dirty(spos);
+  blend(&_value[index(spos)], 1, cell);
 }
 
 void Buffer::operator()(Cell const& cell) {
-  auto& val = _value.at(_size.y - _pos.y - 1).at(_pos.x);
-  if (cell.style.type != Style::Type::Clear && cell.zidx >= val.zidx) {
-    if (cell.style.type == Style::Type::Default) {
-      val = cell;
-    }
-    else {
-      val = Cell{cell.zidx, Style{cell.style.type, cell.style.attr, val.style.fg + cell.style.fg, val.style.bg + cell.style.bg}, cell.text != " " ? cell.text : (val.text.size() && cell.style.bg.a() != 255 ? val.text : " ")};
+  blend(&col(_pos), 1, cell);
+}
+
+void Buffer::fill_span(Point const pos, std::size_t const cols, Cell const& cell) {
+  fill_rect(pos, Size{cols, 1}, cell);
+}
+
+void Buffer::fill_rect(Point const pos, Size const size, Cell const& cell) {
+  // clip against the buffer, anything left is in bounds
+  auto const width = static_cast<std::ptrdiff_t>(_size.x);
+  auto const height = static_cast<std::ptrdiff_t>(_size.y);
+  auto const x0 = std::max<std::ptrdiff_t>(pos.x, 0);
+  auto const x1 = std::min<std::ptrdiff_t>(pos.x + static_cast<std::ptrdiff_t>(size.x), width);
+  auto const y0 = std::max<std::ptrdiff_t>(pos.y, 0);
+  auto const y1 = std::min<std::ptrdiff_t>(pos.y + static_cast<std::ptrdiff_t>(size.y), height);
+  if (x0 >= x1 || y0 >= y1) {return;}
+
+  if (cell.style.type == Style::Type::Clear) {return;}
+  // the whole rect is one batch, most are only a column or two wide
+  auto const cols = static_cast<std::size_t>(x1 - x0);
+  auto& over = over_batch();
+  for (auto y = y0; y < y1; ++y) {
+    auto const spos = Pos(static_cast<std::size_t>(x0), static_cast<std::size_t>(height - y - 1));
+    dirty(spos, cols);
+    auto* vals = &_value[index(spos)];
+    for (std::size_t i = 0; i < cols; ++i) {
+      blend(vals[i], cell, over);
     }
   }
+  over.flush();
 }
 
-void Buffer::put(Pos const pos, Cell const& cell) {
+void Buffer::blend(Cell* vals, std::size_t const count, Cell const& cell) {
+  if (cell.style.type == Style::Type::Clear) {return;}
+  auto& over = over_batch();
+  for (std::size_t i = 0; i < count; ++i) {
+    blend(vals[i], cell, over);
+  }
+  over.flush();
+}
+
+void Buffer::blend(Cell& val, Cell const& cell, Over& over) {
+  if (cell.zidx < val.zidx) {return;}
+  if (cell.style.type == Style::Type::Default) {
+    val = cell;
+    return;
+  }
+  over.add(val.style, cell.style);
+  ++_blended;
+  val.zidx = cell.zidx;
+  val.style.type = cell.style.type;
+  val.style.attr = cell.style.attr;
+  // a translucent space tints what is underneath and keeps its text
+  if (cell.text != glyph_space || cell.style.bg.a() == 255 || val.text.empty()) {
+    val.text = cell.text;
+  }
+}
+
+void Buffer::put(Pos const pos, std::string_view const str, Style const& style, int const zidx) {
   // return on out of bounds
   if (pos.x > _size.x - 1 || pos.y > _size.y - 1) {return;}
   cursor(std::move(pos));
-  put(cell);
+  put(str, style, zidx);
 }
 
-void Buffer::put(Cell const& cell) {
-  OB::Text::View view {cell.text};
+void Buffer::put(std::string_view const str, Style const& style, int const zidx) {
+  bool const space {str == " "};
+  auto& over = over_batch();
+  // printable ascii is one grapheme and one column per byte, skip segmenting
+  if (std::all_of(str.begin(), str.end(), [](char const c) {return c >= 0x20 && c < 0x7f;})) {
+    for (std::size_t i = 0; i < str.size(); ++i) {
+      put_glyph(Glyph(str.substr(i, 1), 1), style, zidx, over, space);
+    }
+    return;
+  }
+  OB::Text::View view {str};
   for (auto const& e : view) {
-    if (e.cols == 2) {
-      if (_pos.x + 1 == _size.x - 1) {
-        _pos.x = 0;
-        if (++_pos.y >= _size.y) {
-          _pos.y = 0;
-        }
+    put_glyph(Glyph(e.str, e.cols), style, zidx, over, space);
+  }
+}
+
+void Buffer::put(Pos const pos, Prepared_text const& text, Style const& style, int const zidx) {
+  // return on out of bounds
+  if (pos.x > _size.x - 1 || pos.y > _size.y - 1) {return;}
+  cursor(std::move(pos));
+  put(text, style, zidx);
+}
+
+void Buffer::put(Prepared_text const& text, Style const& style, int const zidx) {
+  bool const space {text.str() == " "};
+  auto& over = over_batch();
+  for (auto const& glyph : text.glyphs()) {
+    put_glyph(glyph, style, zidx, over, space);
+  }
+}
+
+void Buffer::put_glyph(Glyph const& glyph, Style const& style, int const zidx, Over& over, bool const space) {
+  // composite one glyph, the colours blend onto what is underneath, a wide
+  // glyph does not always move the cursor on, so each one is flushed
+  auto const put_cell = [&](Cell& val) {
+    over.add(val.style, style);
+    over.flush();
+    ++_blended;
+    val.zidx = zidx;
+    val.style.type = style.type;
+    val.style.attr = style.attr;
+    val.text = space && style.bg.a() != 255 && ! val.text.empty() ? val.text : (space ? glyph_space : glyph);
+  };
+  if (glyph.cols() == 2) {
+    if (_pos.x + 1 == _size.x - 1) {
+      _pos.x = 0;
+      if (++_pos.y >= _size.y) {
+        _pos.y = 0;
       }
-      auto& val = _value.at(_size.y - _pos.y - 1).at(_pos.x);
-      if (cell.style.type != Style::Type::Clear && cell.zidx >= val.zidx) {
-        if (val.zidx == 0 || val.style.type == Style::Type::Clear) {
-          val = Cell{cell.zidx, cell.style, std::string{e.str}};
-        }
-        else {
-          val = Cell{cell.zidx, Style{cell.style.type, cell.style.attr, val.style.fg + cell.style.fg, val.style.bg + cell.style.bg}, cell.text != " " ? std::string{e.str} : (val.text.size() && cell.style.bg.a() != 255 ? val.text : " ")};
-        }
+    }
+    auto& val = col(_pos);
+    if (style.type != Style::Type::Clear && zidx >= val.zidx) {
+      if (val.zidx == 0 || val.style.type == Style::Type::Clear) {
+        val = Cell{zidx, style, glyph};
       }
-      if (_pos.x += 2 >= _size.x) {
-        _pos.x = 0;
-        if (++_pos.y >= _size.y) {
-          _pos.y = 0;
-        }
+      else {
+        put_cell(val);
       }
     }
-    else {
-      auto& val = _value.at(_size.y - _pos.y - 1).at(_pos.x);
-      if (cell.style.type != Style::Type::Clear && cell.zidx >= val.zidx) {
-        if (cell.style.type == Style::Type::Default) {
-          val = Cell{cell.zidx, cell.style, std::string{e.str}};
-        }
-        else {
-          val = Cell{cell.zidx, Style{cell.style.type, cell.style.attr, val.style.fg + cell.style.fg, val.style.bg + cell.style.bg}, cell.text != " " ? std::string{e.str} : (val.text.size() && cell.style.bg.a() != 255 ? val.text : " ")};
-        }
+    if (_pos.x += 2 >= _size.x) {
+      _pos.x = 0;
+      if (++_pos.y >= _size.y) {
+        _pos.y = 0;
       }
-      if (++_pos.x >= _size.x) {
-        _pos.x = 0;
-        if (++_pos.y >= _size.y) {
-          _pos.y = 0;
-        }
+    }
+  }
+  else {
+    auto& val = col(_pos);
+    if (style.type != Style::Type::Clear && zidx >= val.zidx) {
+      if (style.type == Style::Type::Default) {
+        val = Cell{zidx, style, glyph};
+      }
+      else {
+        put_cell(val);
+      }
+    }
+    if (++_pos.x >= _size.x) {
+      _pos.x = 0;
+      if (++_pos.y >= _size.y) {
+        _pos.y = 0;
       }
     }
   }
 }
 
+std::size_t Buffer::index(Pos const pos) const {
+  return pos.y * _size.x + pos.x;
+}
+
 Cell& Buffer::at(Pos const pos) {
-  return _value.at(pos.y).at(pos.x);
+  if (pos.x >= _size.x || pos.y >= _size.y) {throw std::out_of_range("Buffer::at");}
+  return _value[index(pos)];
 }
 
 Cell const& Buffer::at(Pos const pos) const {
-  return _value.at(pos.y).at(pos.x);
+  if (pos.x >= _size.x || pos.y >= _size.y) {throw std::out_of_range("Buffer::at");}
+  return _value[index(pos)];
 }
 
-std::vector<Cell>& Buffer::row(std::size_t const y) {
-  return _value.at(_size.y - y - 1);
+Cell& Buffer::operator[](Pos const pos) {
+  return _value[index(pos)];
 }
 
-std::vector<Cell> const& Buffer::row(std::size_t const y) const {
-  return _value.at(_size.y - y - 1);
+Cell const& Buffer::operator[](Pos const pos) const {
+  return _value[index(pos)];
+}
+
+Cell* Buffer::row(std::size_t const y) {
+  return _value.data() + (_size.y - y - 1) * _size.x;
+}
+
+Cell const* Buffer::row(std::size_t const y) const {
+  return _value.data() + (_size.y - y - 1) * _size.x;
 }
 
 Cell& Buffer::col(Pos const pos) {
-  return _value.at(_size.y - pos.y - 1).at(pos.x);
+  auto const spos = Pos(pos.x, _size.y - pos.y - 1);
+  auto& cell = at(spos);
+  dirty(spos);
+  return cell;
 }
 
 Cell const& Buffer::col(Pos const pos) const {
-  return _value.at(_size.y - pos.y - 1).at(pos.x);
+  return at(Pos(pos.x, _size.y - pos.y - 1));
+}
+
+Cell* Buffer::data() {
+  return _value.data();
+}
+
+Cell const* Buffer::data() const {
+  return _value.data();
+}
+
+std::size_t Buffer::stride() const {
+  return _size.x;
 }
 
 Pos Buffer::cursor() const {
@@ -189,13 +468,70 @@ Size Buffer::size() const {
 void Buffer::size(Size const size, Cell const& cell) {
   _size = size;
   _pos = Pos();
-  _value.clear();
-  for (std::size_t h = 0; h < _size.y; ++h) {
-    _value.emplace_back();
-    for (std::size_t w = 0; w < _size.x; ++w) {
-      _value.back().emplace_back(cell);
+  _value.assign(_size.x * _size.y, cell);
+  _dirty.assign(_size.y, Span());
+  _blended = 0;
+}
+
+void Buffer::reset(Cell const& cell) {
+  // overwrite in place, keeps the existing allocation
+  _pos = Pos();
+  std::fill(_value.begin(), _value.end(), cell);
+  std::fill(_dirty.begin(), _dirty.end(), Span());
+  _blended = 0;
+}
+
+void Buffer::erase(Cell const& cell) {
+  _pos = Pos();
+  for (std::size_t y = 0; y < _size.y; ++y) {
+    auto& span = _dirty[y];
+    if (span.empty()) {continue;}
+    auto const begin = _value.begin() + static_cast<std::ptrdiff_t>(y * _size.x);
+    std::fill(begin + static_cast<std::ptrdiff_t>(span.begin), begin + static_cast<std::ptrdiff_t>(span.end), cell);
+    span = Span();
+  }
+  _blended = 0;
+}
+
+void Buffer::compose(Buffer const& layer) {
+  assert(layer._size == _size);
+  auto& over = over_batch();
+  for (std::size_t y = 0; y < _size.y; ++y) {
+    auto const span = layer._dirty[y];
+    if (span.empty()) {continue;}
+    auto const* src = layer._value.data() + y * _size.x;
+    auto* dst = _value.data() + y * _size.x;
+    for (auto x = span.begin; x < span.end; ++x) {
+      // cells the layer never drew show what is underneath
+      if (src[x].style.type == Style::Type::Clear) {continue;}
+      blend(dst[x], src[x], over);
     }
+    dirty(Pos(span.begin, y), span.end - span.begin);
   }
+  over.flush();
+}
+
+void Buffer::shift(std::size_t const y, std::size_t const cols, Cell const& fill) {
+  auto* row = _value.data() + y * _size.x;
+  std::copy(row + cols, row + _size.x, row);
+  std::fill(row + _size.x - cols, row + _size.x, fill);
+  auto& span = _dirty[y];
+  span.begin = span.empty() ? _size.x - cols : (span.begin > cols ? span.begin - cols : 0);
+  span.end = _size.x;
+}
+
+Buffer::Span Buffer::dirty(std::size_t const y) const {
+  return _dirty[y];
+}
+
+void Buffer::dirty(Pos const pos, std::size_t const cols) {
+  auto& span = _dirty[pos.y];
+  if (span.empty()) {
+    span = Span{pos.x, pos.x + cols};
+    return;
+  }
+  span.begin = std::min(span.begin, pos.x);
+  span.end = std::max(span.end, pos.x + cols);
 }
 
 bool Buffer::empty() const {
@@ -206,165 +542,931 @@ void Buffer::clear() {
   _pos = Pos();
   _size = Size();
   _value.clear();
+  _dirty.clear();
+  _blended = 0;
+}
+
+std::size_t Buffer::blended() const {
+  return _blended;
+}
+
+// xterm default values of the 256 colour palette
+struct Rgb {
+  std::uint8_t r {0};
+  std::uint8_t g {0};
+  std::uint8_t b {0};
+};
+
+static constexpr auto palette = []() {
+  std::array<Rgb, 256> table {{
+    {0, 0, 0}, {205, 0, 0}, {0, 205, 0}, {205, 205, 0},
+    {0, 0, 238}, {205, 0, 205}, {0, 205, 205}, {229, 229, 229},
+    {127, 127, 127}, {255, 0, 0}, {0, 255, 0}, {255, 255, 0},
+    {92, 92, 255}, {255, 0, 255}, {0, 255, 255}, {255, 255, 255},
+  }};
+  constexpr std::uint8_t level[6] {0, 95, 135, 175, 215, 255};
+  for (std::size_t i = 0; i < 216; ++i) {
+    table[16 + i] = Rgb{level[i / 36], level[(i / 6) % 6], level[i % 6]};
+  }
+  for (std::size_t i = 0; i < 24; ++i) {
+    auto const v = static_cast<std::uint8_t>(8 + i * 10);
+    table[232 + i] = Rgb{v, v, v};
+  }
+  return table;
+}();
+
+// nearest palette entry in [begin, end) for every colour at 5 bits per channel
+static std::vector<std::uint8_t> palette_lut(std::size_t const begin, std::size_t const end) {
+  std::vector<std::uint8_t> lut(32 * 32 * 32);
+  for (std::size_t i = 0; i < lut.size(); ++i) {
+    // centre of the bucket
+    int const r = static_cast<int>(((i >> 10) << 3) | 4);
+    int const g = static_cast<int>((((i >> 5) & 31) << 3) | 4);
+    int const b = static_cast<int>(((i & 31) << 3) | 4);
+    int best {std::numeric_limits<int>::max()};
+    for (std::size_t j = begin; j < end; ++j) {
+      auto const& e = palette[j];
+      int const dr {r - e.r};
+      int const dg {g - e.g};
+      int const db {b - e.b};
+      int const dist {dr * dr + dg * dg + db * db};
+      if (dist < best) {
+        best = dist;
+        lut[i] = static_cast<std::uint8_t>(j);
+      }
+    }
+  }
+  return lut;
+}
+
+// the 16 colour palette is left to the terminal theme, so the 256 colour
+// mode only picks from the cube and the grey ramp
+static std::uint8_t palette_index(OB::Prism::RGBA const& rgba, std::uint8_t const depth) {
+  static auto const lut_8 = palette_lut(16, 256);
+  static auto const lut_4 = palette_lut(0, 16);
+  auto const key = static_cast<std::size_t>(((rgba.r() >> 3) << 10) | ((rgba.g() >> 3) << 5) | (rgba.b() >> 3));
+  return depth == Style::Bit_8 ? lut_8[key] : lut_4[key];
+}
+
+static OB::Prism::RGBA palette_rgba(std::uint8_t const index) {
+  auto const& e = palette[index];
+  return OB::Prism::RGBA{e.r, e.g, e.b, std::uint8_t{255}};
+}
+
+// colours that encode to the same sequence at the output depth
+static bool same_colour(OB::Prism::RGBA const& lhs, OB::Prism::RGBA const& rhs, std::uint8_t const depth) {
+  if (lhs == rhs) {return true;}
+  if (depth == Style::Bit_24) {return false;}
+  return palette_index(lhs, depth) == palette_index(rhs, depth);
+}
+
+// bytes of a cell the diff compares, text, attr, type, fg and bg, the zidx and
+// the padding are left out, laid out for a block of cells so the vector
+// kernels can load it in step with the rows
+static constexpr std::size_t cell_block {4};
+
+static constexpr auto cell_mask = []() {
+  std::array<std::uint8_t, sizeof(Cell) * cell_block> mask {};
+  auto const set = [&](std::size_t const begin, std::size_t const size) {
+    for (std::size_t i = 0; i < cell_block; ++i) {
+      for (std::size_t j = 0; j < size; ++j) {
+        mask[i * sizeof(Cell) + begin + j] = 0xff;
+      }
+    }
+  };
+  set(offsetof(Cell, style) + offsetof(Style, type), sizeof(Style::type));
+  set(offsetof(Cell, style) + offsetof(Style, attr), sizeof(Style::attr));
+  set(offsetof(Cell, style) + offsetof(Style, fg), sizeof(Style::fg));
+  set(offsetof(Cell, style) + offsetof(Style, bg), sizeof(Style::bg));
+  set(offsetof(Cell, text), sizeof(Cell::text));
+  return mask;
+}();
+static_assert(sizeof(Cell) % sizeof(std::uint64_t) == 0);
+
+// first column in [x, end) whose compared bytes differ, or end
+using Diff_fn = std::size_t (*)(Cell const* lhs, Cell const* rhs, std::size_t x, std::size_t const end);
+
+static std::size_t next_diff_scalar(Cell const* lhs, Cell const* rhs, std::size_t x, std::size_t const end) {
+  static auto const mask = []() {
+    std::array<std::uint64_t, sizeof(Cell) / sizeof(std::uint64_t)> words;
+    std::memcpy(words.data(), cell_mask.data(), sizeof(words));
+    return words;
+  }();
+
+  for (; x < end; ++x) {
+    std::array<std::uint64_t, mask.size()> a;
+    std::array<std::uint64_t, mask.size()> b;
+    std::memcpy(a.data(), lhs + x, sizeof(a));
+    std::memcpy(b.data(), rhs + x, sizeof(b));
+    std::uint64_t diff {0};
+    for (std::size_t i = 0; i < mask.size(); ++i) {
+      diff |= (a[i] ^ b[i]) & mask[i];
+    }
+    if (diff) {return x;}
+  }
+  return end;
+}
+
+#if defined(__SSE2__)
+// two cells per step, 48 bytes in three loads
+static std::size_t next_diff_sse2(Cell const* lhs, Cell const* rhs, std::size_t x, std::size_t const end) {
+  auto const* a = reinterpret_cast<char const*>(lhs);
+  auto const* b = reinterpret_cast<char const*>(rhs);
+  auto const* m = reinterpret_cast<__m128i const*>(cell_mask.data());
+  __m128i const m0 {_mm_loadu_si128(m)};
+  __m128i const m1 {_mm_loadu_si128(m + 1)};
+  __m128i const m2 {_mm_loadu_si128(m + 2)};
+
+  for (; x + 2 <= end; x += 2) {
+    auto const* pa = reinterpret_cast<__m128i const*>(a + x * sizeof(Cell));
+    auto const* pb = reinterpret_cast<__m128i const*>(b + x * sizeof(Cell));
+    auto const d0 = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_loadu_si128(pa), _mm_loadu_si128(pb)), m0);
+    auto const d1 = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_loadu_si128(pa + 1), _mm_loadu_si128(pb + 1)), m1);
+    auto const d2 = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_loadu_si128(pa + 2), _mm_loadu_si128(pb + 2)), m2);
+    auto const bits = static_cast<std::uint64_t>(static_cast<unsigned int>(_mm_movemask_epi8(d0))) |
+      (static_cast<std::uint64_t>(static_cast<unsigned int>(_mm_movemask_epi8(d1))) << 16) |
+      (static_cast<std::uint64_t>(static_cast<unsigned int>(_mm_movemask_epi8(d2))) << 32);
+    if (bits) {return x + static_cast<std::size_t>(__builtin_ctzll(bits)) / sizeof(Cell);}
+  }
+  return next_diff_scalar(lhs, rhs, x, end);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+// four cells per step, 96 bytes in three loads
+__attribute__((target("avx2")))
+static std::size_t next_diff_avx2(Cell const* lhs, Cell const* rhs, std::size_t x, std::size_t const end) {
+  auto const* a = reinterpret_cast<char const*>(lhs);
+  auto const* b = reinterpret_cast<char const*>(rhs);
+  auto const* m = reinterpret_cast<__m256i const*>(cell_mask.data());
+  __m256i const m0 {_mm256_loadu_si256(m)};
+  __m256i const m1 {_mm256_loadu_si256(m + 1)};
+  __m256i const m2 {_mm256_loadu_si256(m + 2)};
+
+  for (; x + 4 <= end; x += 4) {
+    auto const* pa = reinterpret_cast<__m256i const*>(a + x * sizeof(Cell));
+    auto const* pb = reinterpret_cast<__m256i const*>(b + x * sizeof(Cell));
+    auto const d0 = _mm256_andnot_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(pa), _mm256_loadu_si256(pb)), m0);
+    auto const d1 = _mm256_andnot_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(pa + 1), _mm256_loadu_si256(pb + 1)), m1);
+    auto const d2 = _mm256_andnot_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(pa + 2), _mm256_loadu_si256(pb + 2)), m2);
+    auto const b0 = static_cast<unsigned int>(_mm256_movemask_epi8(d0));
+    if (b0) {return x + static_cast<std::size_t>(__builtin_ctz(b0)) / sizeof(Cell);}
+    auto const b1 = static_cast<unsigned int>(_mm256_movemask_epi8(d1));
+    if (b1) {return x + (32 + static_cast<std::size_t>(__builtin_ctz(b1))) / sizeof(Cell);}
+    auto const b2 = static_cast<unsigned int>(_mm256_movemask_epi8(d2));
+    if (b2) {return x + (64 + static_cast<std::size_t>(__builtin_ctz(b2))) / sizeof(Cell);}
+  }
+#if defined(__SSE2__)
+  return next_diff_sse2(lhs, rhs, x, end);
+#else
+  return next_diff_scalar(lhs, rhs, x, end);
+#endif
+}
+#endif
+
+// picked once from what the cpu supports
+static Diff_fn const next_diff = []() -> Diff_fn {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {return next_diff_avx2;}
+#endif
+#if defined(__SSE2__)
+  return next_diff_sse2;
+#else
+  return next_diff_scalar;
+#endif
+}();
+
+Window::~Window() {
+  present_stop();
+  if (out_nonblock) {
+    ::fcntl(out->native_handle(), F_SETFL, out_flags);
+  }
 }
 
 void Window::winch() {
   clear = true;
-  style = style_base;
-  buf.size(size, Cell{0, style, " "});
-  buf_prev = buf;
+  buf.size(size, Cell{0, style_base, " "});
+  if (record) {
+    record->resize(size.x, size.y);
+  }
 }
 
 void Window::refresh() {
   clear = true;
-  style = style_base;
-  buf_prev = buf;
 }
 
 void Window::render() {
-  if (clear) {
-    clear = false;
-    line += aec::cursor_set(1, buf.size().y);
-    line += aec::clear;
-    if (style.type != Style::Type::Clear) {
-      if (style.attr != Style::Null) {
-        if (style.attr & Style::Bold) {line += aec::bold;}
-        if (style.attr & Style::Reverse) {line += aec::reverse;}
-        if (style.attr & Style::Underline) {line += aec::underline;}
+  if (threaded) {
+    publish();
+    return;
+  }
+
+  if (out_busy) {
+    // the terminal is still taking the last frame, drop this one rather than
+    // queue more bytes, the next frame is diffed against buf_prev, the last
+    // frame actually sent
+    ++dropped;
+    ++dropped_run;
+    buf.reset(Cell{0, style_base, " "});
+    return;
+  }
+  if (dropped_run) {
+    ++merged;
+    dropped_run = 0;
+  }
+
+  present(buf, buf_prev);
+
+  flip();
+}
+
+void Window::present(Buffer const& cur, Buffer& prev) {
+  bsize = 0;
+  wcount = 0;
+  encode(cur, prev);
+  // the whole frame goes out in a single write
+  write(enc.line);
+}
+
+void Window::encode(Buffer const& cur, Buffer& prev) {
+  auto const height = cur.size().y;
+  // may be lowered at runtime, which also asks for a clear
+  enc.depth = depth.load(std::memory_order_relaxed);
+
+  if (clear.exchange(false) || prev.size() != cur.size()) {
+    // the screen is cleared to the base style, match it without copying cur
+    if (prev.size() != cur.size()) {
+      prev.size(cur.size(), Cell{0, style_base, " "});
+    }
+    else {
+      prev.reset(Cell{0, style_base, " "});
+    }
+    enc.cursor_set(Pos(0, height - 1));
+    enc.cursor = Pos(0, height - 1);
+    enc.cursor_valid = true;
+    // reset then apply the base style, so the cleared screen takes its background
+    enc.sgr(style_base, true);
+    enc.line += aec::screen_clear;
+  }
+
+  if (scroll && !diff_full) {
+    scroll_rows(cur, prev);
+  }
+
+  // bands only pay for their restarts when they run side by side, a single
+  // thread encodes the frame in one pass
+  auto const count = std::max<std::size_t>(1, (height + band_rows - 1) / band_rows);
+  if (count == 1 || !pool) {
+    enc.rows(cur, prev, 0, height, diff_full);
+    return;
+  }
+
+  // the first band carries on from the terminal state, the rest start unknown
+  bands.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    auto& band = bands[i];
+    band.line.clear();
+    band.cursor_valid = false;
+    band.style = Style{};
+    band.depth = enc.depth;
+  }
+  std::swap(bands[0].line, enc.line);
+  bands[0].cursor = enc.cursor;
+  bands[0].cursor_valid = enc.cursor_valid;
+  bands[0].style = enc.style;
+
+  auto const fn = [&](std::size_t const i) {
+    bands[i].rows(cur, prev, i * band_rows, std::min(height, (i + 1) * band_rows), diff_full);
+  };
+  // passed by reference, the std::function holds a pointer, not a copy on the heap
+  pool->run(count, std::ref(fn));
+
+  // concatenate in order, the terminal ends up as the last band that wrote
+  // anything left it
+  std::swap(enc.line, bands[0].line);
+  enc.cursor = bands[0].cursor;
+  enc.cursor_valid = bands[0].cursor_valid;
+  enc.style = bands[0].style;
+  for (std::size_t i = 1; i < count; ++i) {
+    auto const& band = bands[i];
+    if (band.line.empty()) {continue;}
+    enc.line += band.line;
+    enc.cursor = band.cursor;
+    enc.cursor_valid = band.cursor_valid;
+    enc.style = band.style;
+  }
+}
+
+void Encoder::rows(Buffer const& cur, Buffer const& prev, std::size_t const begin, std::size_t const end, bool const full) {
+  auto const width = cur.size().x;
+
+  for (std::size_t y = begin; y < end; ++y) {
+    auto const* cells = cur.data() + y * cur.stride();
+    auto const* prevs = prev.data() + y * prev.stride();
+
+    // both frames are drawn over the same base, so a cell can only differ
+    // where either frame wrote to it
+    auto span = cur.dirty(y);
+    auto const span_prev = prev.dirty(y);
+    if (span.empty()) {
+      span = span_prev;
+    }
+    else if (!span_prev.empty()) {
+      span.begin = std::min(span.begin, span_prev.begin);
+      span.end = std::max(span.end, span_prev.end);
+    }
+    if (full) {
+      span = Buffer::Span{0, width};
+    }
+    span.end = std::min(span.end, width);
+
+#ifdef DEBUG
+    for (std::size_t x = 0; x < width; ++x) {
+      if (x >= span.begin && x < span.end) {continue;}
+      assert(cells[x].text == prevs[x].text && cells[x].style.fg == prevs[x].style.fg && cells[x].style.bg == prevs[x].style.bg);
+    }
+#endif
+
+    for (auto x = next_diff(cells, prevs, span.begin, span.end); x < span.end; x = next_diff(cells, prevs, x + 1, span.end)) {
+      auto const& cell = cells[x];
+      auto const& last = prevs[x];
+
+      // quantized colours can differ and still encode the same
+      if (depth != Style::Type::Bit_24 &&
+          cell.text == last.text &&
+          cell.style.attr == last.style.attr &&
+          cell.style.type == last.style.type &&
+          same_colour(cell.style.fg, last.style.fg, depth) &&
+          same_colour(cell.style.bg, last.style.bg, depth)) {
+        continue;
       }
-      if (style.type == Style::Bit_24) {
-        term_fg(line, style.fg);
-        term_bg(line, style.bg);
+
+      cursor_move(cells, Pos(x, y));
+      sgr(cell.style);
+      line += cell.text.str();
+      cursor_advance(cell.text.cols(), width);
+    }
+  }
+}
+
+void Window::scroll_rows(Buffer const& cur, Buffer& prev) {
+  auto const width = cur.size().x;
+  if (width <= scroll_max * 2) {return;}
+  // bytes of moving to a row and deleting, counted in cells drawn instead
+  std::size_t const cost {4};
+
+  // cells of cells that differ from prevs over [begin, end), giving up past limit
+  auto const count = [](Cell const* cells, Cell const* prevs, std::size_t const begin, std::size_t const end, std::size_t const limit) {
+    std::size_t n {0};
+    for (auto x = next_diff(cells, prevs, begin, end); x < end && n < limit; x = next_diff(cells, prevs, x + 1, end)) {
+      ++n;
+    }
+    return n;
+  };
+
+  for (std::size_t y = 0; y < cur.size().y; ++y) {
+    auto const* cells = cur.data() + y * width;
+    auto const* prevs = prev.data() + y * width;
+
+    // outside both spans the row is the base in either frame
+    auto span = cur.dirty(y);
+    auto const span_prev = prev.dirty(y);
+    if (span.empty()) {span = span_prev;}
+    else if (!span_prev.empty()) {
+      span.begin = std::min(span.begin, span_prev.begin);
+      span.end = std::max(span.end, span_prev.end);
+    }
+    if (span.end - span.begin <= cost) {continue;}
+
+    auto best = count(cells, prevs, span.begin, span.end, width);
+    std::size_t shift {0};
+    for (std::size_t n = 1; n <= scroll_max && best > cost + n; ++n) {
+      // cur against prev moved left by n, the last n columns come in unknown
+      auto const diff = count(cells, prevs + n, 0, width - n, best) + n + cost;
+      if (diff < best) {
+        best = diff;
+        shift = n;
       }
     }
-    line += aec::screen_clear;
-    write(line);
+    if (shift == 0) {continue;}
+
+    // terminals disagree on deleting part of a wide glyph, leave those rows be
+    auto const narrow = [width](Cell const* row) {
+      return std::all_of(row, row + width, [](auto const& cell) {return cell.text.cols() <= 1;});
+    };
+    if (!narrow(cells) || !narrow(prevs)) {continue;}
+
+    enc.delete_chars(cells, Pos(0, y), shift);
+    prev.shift(y, shift);
+    ++scrolled;
   }
+}
 
-  for (std::size_t y = 0; y < buf.size().y; ++y) {
-    for (std::size_t x = 0; x < buf.size().x; ++x) {
-      auto const& cell = buf.at(Pos(x, y));
-      auto const& prev = buf_prev.at(Pos(x, y));
+void Window::publish() {
+  if (present_failed) {
+    present_stop();
+    std::rethrow_exception(present_error);
+  }
+  if (!present_thread.joinable()) {
+    present_start();
+  }
 
-      if ((cell.text != prev.text) ||
-          (cell.style.attr != prev.style.attr) ||
-          (cell.style.type != prev.style.type) ||
-          (cell.style.fg != prev.style.fg) ||
-          (cell.style.bg != prev.style.bg)) {
+  std::swap(buf, queue.back());
+  if (!queue.publish()) {
+    // the presenter had not picked up the last frame yet, it was replaced
+    ++dropped;
+  }
+  {
+    // only orders the wakeup against the presenter going to sleep
+    std::lock_guard<std::mutex> lock {present_mutex};
+  }
+  present_cond.notify_one();
 
-        bool diff_attr {style.attr != cell.style.attr};
-        bool diff_type {style.type != cell.style.type};
-        bool diff_fg {style.fg != cell.style.fg};
-        bool diff_bg {style.bg != cell.style.bg};
+  // recycle the slot handed back, either an overwritten frame or one the
+  // presenter is done with
+  std::swap(buf, queue.back());
+  if (buf.size() != size) {
+    buf.size(size, Cell{0, style_base, " "});
+  }
+  else {
+    buf.reset(Cell{0, style_base, " "});
+  }
+}
 
-        line += aec::cursor_set(x + 1, y + 1);
+void Window::present_start() {
+  present_run = true;
+  present_failed = false;
+  present_thread = std::thread([&]() {present_loop();});
+}
 
-        if (diff_type) {
-          style.type = cell.style.type;
-          if (style.type == Style::Type::Default) {
-            line += aec::clear;
-          }
-        }
+void Window::present_stop() {
+  if (!present_thread.joinable()) {return;}
+  {
+    std::lock_guard<std::mutex> lock {present_mutex};
+    present_run = false;
+  }
+  present_cond.notify_one();
+  present_thread.join();
+}
 
-        if (diff_attr) {
-          diff_fg = true;
-          diff_bg = true;
-          style.attr = cell.style.attr;
-          line += aec::clear;
-          if (style.attr != Style::Null) {
-            if (style.attr & Style::Bold) {line += aec::bold;}
-            if (style.attr & Style::Reverse) {line += aec::reverse;}
-            if (style.attr & Style::Underline) {line += aec::underline;}
-          }
-        }
+void Window::present_loop() {
+  try {
+    while (present_run) {
+      {
+        std::unique_lock<std::mutex> lock {present_mutex};
+        present_cond.wait(lock, [&]() {return !present_run || queue.pending();});
+      }
+      if (!queue.acquire()) {continue;}
 
-        if (cell.style.type == Style::Type::Clear) {
-          style = Style();
-          line += aec::clear;
-        }
-        else if (cell.style.type == Style::Bit_24) {
-          if (diff_fg) {
-            style.fg = cell.style.fg;
-            term_fg(line, style.fg);
-          }
+      auto& frame = queue.front();
+      present(frame, buf_prev);
+      // keep the presented frame to diff the next one against
+      std::swap(frame, buf_prev);
+      ++frames;
+    }
+  }
+  catch (...) {
+    // rethrown on the tick thread at the next render
+    present_error = std::current_exception();
+    present_failed = true;
+  }
+}
+
+static std::size_t digits(std::size_t num) {
+  std::size_t n {1};
+  while (num >= 10) {
+    num /= 10;
+    ++n;
+  }
+  return n;
+}
+
+// decimal text of every byte value, the common case for sgr and cursor parameters
+struct Decimal {
+  char str[3] {};
+  std::uint8_t size {0};
+};
+
+static constexpr auto decimal_table = []() {
+  std::array<Decimal, 256> table {};
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    auto& e = table[i];
+    if (i >= 100) {e.str[e.size++] = static_cast<char>('0' + i / 100);}
+    if (i >= 10) {e.str[e.size++] = static_cast<char>('0' + (i / 10) % 10);}
+    e.str[e.size++] = static_cast<char>('0' + i % 10);
+  }
+  return table;
+}();
+
+static void write_num(std::string& str, std::size_t num) {
+  if (num < decimal_table.size()) {
+    auto const& e = decimal_table[num];
+    str.append(e.str, e.size);
+    return;
+  }
+  char buf[20];
+  char* const end {buf + sizeof(buf)};
+  char* ptr {end};
+  do {
+    *--ptr = static_cast<char>('0' + num % 10);
+    num /= 10;
+  } while (num);
+  str.append(ptr, static_cast<std::size_t>(end - ptr));
+}
+
+static void write_rgb(std::string& str, OB::Prism::RGBA const& rgba) {
+  str += ";2;";
+  write_num(str, rgba.r());
+  str += ';';
+  write_num(str, rgba.g());
+  str += ';';
+  write_num(str, rgba.b());
+}
+
+static void csi(std::string& str, std::size_t const num, char const fn) {
+  str += "\x1b[";
+  if (num != 1) {write_num(str, num);}
+  str += fn;
+}
+
+void Encoder::delete_chars(Cell const* cells, Pos const pos, std::size_t const cols) {
+  cursor_move(cells, pos);
+  csi(line, cols, 'P');
+}
+
+void Encoder::cursor_set(Pos const pos) {
+  line += "\x1b[";
+  write_num(line, pos.y + 1);
+  line += ';';
+  write_num(line, pos.x + 1);
+  line += 'H';
+}
+
+void Encoder::sgr(Style const& next, bool reset) {
+  std::uint8_t const type = next.type == Style::Type::Clear ? static_cast<std::uint8_t>(Style::Type::Default) : next.type;
+  auto const attr = next.attr;
+
+  // dropping an attribute or leaving truecolor needs a full reset
+  if ((style.attr & ~attr) || (style.type != type && type == Style::Type::Default) || style.type == Style::Type::Clear) {
+    reset = true;
+  }
+
+  auto const mark = line.size();
+  line += "\x1b[";
+  char const* sep {""};
+  auto const param = [&](char const* val) {
+    line += sep;
+    line += val;
+    sep = ";";
+  };
 
-          if (diff_bg) {
-            style.bg = cell.style.bg;
-            term_bg(line, style.bg);
+  if (reset) {
+    param("0");
+    style = Style{Style::Type::Default, Style::Null, {}, {}};
+  }
+
+  auto const attr_add = static_cast<std::uint8_t>(attr & ~style.attr);
+  if (attr_add & Style::Bold) {param("1");}
+  if (attr_add & Style::Reverse) {param("7");}
+  if (attr_add & Style::Underline) {param("4");}
+
+  if (type == Style::Type::Bit_24 && depth != Style::Type::Bit_24) {
+    // quantized, the tracked colours are the palette values sent
+    auto const fg = palette_index(next.fg, depth);
+    auto const bg = palette_index(next.bg, depth);
+    auto const fg_rgba = palette_rgba(fg);
+    auto const bg_rgba = palette_rgba(bg);
+    auto const index = [&](std::uint8_t const val, bool const back) {
+      if (depth == Style::Type::Bit_8) {
+        param(back ? "48;5;" : "38;5;");
+        write_num(line, val);
+        return;
+      }
+      param("");
+      write_num(line, static_cast<std::size_t>(val < 8 ? (back ? 40 : 30) + val : (back ? 92 : 82) + val));
+    };
+    if (style.type != Style::Type::Bit_24 || style.fg != fg_rgba) {
+      index(fg, false);
+    }
+    if (style.type != Style::Type::Bit_24 || style.bg != bg_rgba) {
+      index(bg, true);
+    }
+    style = Style{type, attr, fg_rgba, bg_rgba};
+  }
+  else if (type == Style::Type::Bit_24) {
+    if (style.type != Style::Type::Bit_24 || style.fg != next.fg) {
+      param("38");
+      write_rgb(line, next.fg);
+    }
+    if (style.type != Style::Type::Bit_24 || style.bg != next.bg) {
+      param("48");
+      write_rgb(line, next.bg);
+    }
+    style = Style{type, attr, next.fg, next.bg};
+  }
+  else {
+    style = Style{type, attr, {}, {}};
+  }
+
+  if (*sep) {
+    line += 'm';
+  }
+  else {
+    // nothing changed
+    line.resize(mark);
+  }
+}
+
+static bool same_style(Style const& lhs, Style const& rhs) {
+  if (lhs.type != rhs.type || lhs.attr != rhs.attr) {return false;}
+  if (lhs.type == Style::Type::Clear) {return false;}
+  if (lhs.type == Style::Type::Default) {return true;}
+  return lhs.fg == rhs.fg && lhs.bg == rhs.bg;
+}
+
+void Encoder::cursor_move(Cell const* cells, Pos const pos) {
+  enum class Move {Set, Right, Left, Home, Home_right, Next_line, Rewrite};
+
+  // absolute position, always valid
+  Move move {Move::Set};
+  std::size_t cost {4 + digits(pos.y + 1) + digits(pos.x + 1)};
+  auto const cheaper = [&](Move const m, std::size_t const c) {
+    if (c < cost) {
+      move = m;
+      cost = c;
+    }
+  };
+
+  if (cursor_valid) {
+    if (cursor.y == pos.y) {
+      if (cursor.x == pos.x) {return;}
+
+      if (pos.x > cursor.x) {
+        auto const n = pos.x - cursor.x;
+        cheaper(Move::Right, n == 1 ? 3 : 3 + digits(n));
+
+        // reprint the unchanged cells in between if they share the current style
+        std::size_t bytes {0};
+        for (std::size_t x = cursor.x; x < pos.x && bytes < cost; ++x) {
+          auto const& cell = cells[x];
+          if (cell.text.cols() != 1 || !same_style(style, cell.style)) {
+            bytes = cost;
+            break;
           }
+          bytes += cell.text.size();
+        }
+        cheaper(Move::Rewrite, bytes);
+      }
+      else {
+        auto const n = cursor.x - pos.x;
+        cheaper(Move::Left, n == 1 ? 3 : 3 + digits(n));
+        if (pos.x == 0) {
+          cheaper(Move::Home, 1);
         }
+        else {
+          cheaper(Move::Home_right, 1 + (pos.x == 1 ? 3 : 3 + digits(pos.x)));
+        }
+      }
+    }
+    else if (pos.y == cursor.y + 1 && pos.x == 0) {
+      cheaper(Move::Next_line, 2);
+    }
+  }
 
-        line += cell.text;
+  switch (move) {
+    case Move::Set: {
+      cursor_set(pos);
+      break;
+    }
+    case Move::Right: {
+      csi(line, pos.x - cursor.x, 'C');
+      break;
+    }
+    case Move::Left: {
+      csi(line, cursor.x - pos.x, 'D');
+      break;
+    }
+    case Move::Home: {
+      line += "\r";
+      break;
+    }
+    case Move::Home_right: {
+      line += "\r";
+      csi(line, pos.x, 'C');
+      break;
+    }
+    case Move::Next_line: {
+      line += "\r\n";
+      break;
+    }
+    case Move::Rewrite: {
+      for (std::size_t x = cursor.x; x < pos.x; ++x) {
+        line += cells[x].text.str();
       }
+      break;
+    }
+    default: {
+      break;
     }
-    bsize += line.size();
-    write(line);
   }
 
-  bsize = 0;
-  buf_prev = buf;
-  buf.size(buf.size(), Cell{0, style_base, " "});
-  ++frames;
+  cursor = pos;
+  cursor_valid = true;
+}
+
+void Encoder::cursor_advance(std::size_t const cols, std::size_t const width) {
+  cursor.x += cols;
+  // past the last column the terminal is in its pending wrap state
+  if (cursor.x >= width) {
+    cursor_valid = false;
+  }
+}
+
+static std::string_view constexpr sync_begin {"\x1b[?2026h"};
+static std::string_view constexpr sync_end {"\x1b[?2026l"};
+
+// block until fd can take more bytes, instead of spinning on EAGAIN
+static void wait_writable(int const fd) {
+  pollfd pfd {fd, POLLOUT, 0};
+  while (::poll(&pfd, 1, -1) < 0 && errno == EINTR) {}
+}
+
+void Window::output(boost::asio::io_context& io) {
+  out = std::make_unique<boost::asio::posix::stream_descriptor>(io, ::dup(STDOUT_FILENO));
+  out_flags = ::fcntl(out->native_handle(), F_GETFL);
+  if (out_flags < 0) {throw std::runtime_error("fcntl failed");}
 }
 
 void Window::write(std::string& str) {
   if (str.empty()) {return;}
-  int num {0};
-  char const* ptr {str.data()};
-  std::size_t size {str.size()};
-  while (size > 0 && static_cast<std::size_t>(num = ::write(STDOUT_FILENO, ptr, size)) != size) {
+
+  if (out) {
+    out_buf.clear();
+    if (sync) {out_buf += sync_begin;}
+    out_buf += str;
+    if (sync) {out_buf += sync_end;}
+    str.clear();
+    out_pos = 0;
+    out_busy = true;
+    out_begin = std::chrono::steady_clock::now();
+    if (record) {
+      record->output(out_buf);
+    }
+    bsize += out_buf.size();
+    if (!out_nonblock) {
+      if (::fcntl(out->native_handle(), F_SETFL, out_flags | O_NONBLOCK) < 0) {throw std::runtime_error("fcntl failed");}
+      out_nonblock = true;
+    }
+    write_async();
+    return;
+  }
+
+  if (record) {
+    // the frame as the terminal gets it
+    record->output(sync ? std::string(sync_begin) + str + std::string(sync_end) : str);
+  }
+
+  std::array<iovec, 3> iov;
+  std::size_t count {0};
+  if (sync) {
+    iov[count++] = iovec{const_cast<char*>(sync_begin.data()), sync_begin.size()};
+  }
+  iov[count++] = iovec{str.data(), str.size()};
+  if (sync) {
+    iov[count++] = iovec{const_cast<char*>(sync_end.data()), sync_end.size()};
+  }
+
+  auto const begin = std::chrono::steady_clock::now();
+  iovec* ptr {iov.data()};
+  while (count > 0) {
+    auto num = ::writev(STDOUT_FILENO, ptr, static_cast<int>(count));
+    ++wcount;
     if (num < 0) {
-      if (errno == EINTR || errno == EAGAIN) {continue;}
+      if (errno == EINTR) {continue;}
+      if (errno == EAGAIN) {
+        wait_writable(STDOUT_FILENO);
+        continue;
+      }
       throw std::runtime_error("write failed");
     }
-    size -= static_cast<std::size_t>(num);
-    ptr += static_cast<std::size_t>(num);
+    bsize += static_cast<std::size_t>(num);
+    // skip the fully written buffers and advance into a partial one
+    auto len = static_cast<std::size_t>(num);
+    while (count > 0 && len >= ptr->iov_len) {
+      len -= ptr->iov_len;
+      ++ptr;
+      --count;
+    }
+    if (count > 0) {
+      ptr->iov_base = static_cast<char*>(ptr->iov_base) + len;
+      ptr->iov_len -= len;
+    }
   }
+  wtime = std::chrono::steady_clock::now() - begin;
   str.clear();
 }
 
-void Window::render_file(std::ofstream& file) {
-  for (std::size_t y = 0; y < buf.size().y; ++y) {
-    for (std::size_t x = 0; x < buf.size().x; ++x) {
-      auto const& cell = buf.at(Pos(x, y));
-      line += cell.text;
+void Window::write_async() {
+  // bytes only reach the terminal here and out_pos moves with them, the
+  // reactor is only asked when the fd can take more, so a cancelled wait has
+  // written nothing and drain can carry on from out_pos
+  while (out_pos < out_buf.size()) {
+    auto num = ::write(out->native_handle(), out_buf.data() + out_pos, out_buf.size() - out_pos);
+    if (num < 0) {
+      if (errno == EINTR) {continue;}
+      if (errno != EAGAIN) {throw std::runtime_error("write failed");}
+      out->async_wait(boost::asio::posix::stream_descriptor::wait_write, [&](auto ec) {
+        // a wait left over from a drained frame
+        if (ec == boost::asio::error::operation_aborted || !out_busy) {return;}
+        if (ec) {throw std::runtime_error("write failed");}
+        write_async();
+      });
+      return;
+    }
+    ++wcount;
+    out_pos += static_cast<std::size_t>(num);
+  }
+  out_busy = false;
+  wtime = std::chrono::steady_clock::now() - out_begin;
+}
+
+void Window::drain() {
+  // the presenter finishes the frame it is writing, unread frames are dropped,
+  // it starts again with the next render
+  present_stop();
+  if (out_busy) {
+    // out_pos counts every byte written so far, see write_async
+    out->cancel();
+    while (out_pos < out_buf.size()) {
+      auto num = ::write(STDOUT_FILENO, out_buf.data() + out_pos, out_buf.size() - out_pos);
+      if (num < 0) {
+        if (errno == EINTR) {continue;}
+        if (errno == EAGAIN) {
+          wait_writable(STDOUT_FILENO);
+          continue;
+        }
+        throw std::runtime_error("write failed");
+      }
+      out_pos += static_cast<std::size_t>(num);
     }
-    bsize += line.size();
-    line += "\n";
-    write(line);
-    // write_file(file, line);
+    out_busy = false;
+  }
+  // blocking again before anything else writes to the terminal or runs on it
+  if (out_nonblock) {
+    if (::fcntl(out->native_handle(), F_SETFL, out_flags) < 0) {throw std::runtime_error("fcntl failed");}
+    out_nonblock = false;
   }
+}
 
+void Window::render_buffer() {
+  // the frame is only kept, in buf_prev, until the next render
   bsize = 0;
-  buf_prev = buf;
-  buf.size(buf.size(), Cell{0, style_base, " "});
+  wcount = 0;
+  flip();
+}
+
+void Window::flip() {
+  // keep the frame just rendered and start the next one from the base, buf_prev
+  // is only sized on the first frame when nothing presented it yet
+  std::swap(buf, buf_prev);
+  if (buf.size() != buf_prev.size()) {
+    buf.size(buf_prev.size(), Cell{0, style_base, " "});
+  }
+  else {
+    buf.reset(Cell{0, style_base, " "});
+  }
   ++frames;
 }
 
+void Window::render_file(std::ofstream& file, bool const ansi) {
+  bsize = 0;
+  wcount = 0;
+
+  if (ansi) {
+    // the same bytes a terminal would get
+    encode(buf, buf_prev);
+  }
+  else {
+    for (std::size_t y = 0; y < buf.size().y; ++y) {
+      auto const* cells = buf.data() + y * buf.stride();
+      for (std::size_t x = 0; x < buf.size().x; ++x) {
+        auto const& cell = cells[x];
+        enc.line += cell.text.str();
+      }
+      enc.line += "\n";
+    }
+  }
+  write_file(file, enc.line);
+
+  flip();
+}
+
 void Window::write_file(std::ofstream& file, std::string& str) {
   if (str.empty()) {return;}
-  file.seekp(0);
-  file << str << std::flush;
+  file << str;
   if (!file) {throw std::runtime_error("write failed");}
+  bsize += str.size();
+  ++wcount;
   str.clear();
 }
-
-void Window::term_fg(std::string& str, OB::Prism::RGBA rgba) {
-  str += "\x1b[38;2;";
-  str += std::to_string(rgba.r());
-  str += ";";
-  str += std::to_string(rgba.g());
-  str += ";";
-  str += std::to_string(rgba.b());
-  str += "m";
-}
-
-void Window::term_bg(std::string& str, OB::Prism::RGBA rgba) {
-  str += "\x1b[48;2;";
-  str += std::to_string(rgba.r());
-  str += ";";
-  str += std::to_string(rgba.g());
-  str += ";";
-  str += std::to_string(rgba.b());
-  str += "m";
-}
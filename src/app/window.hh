@@ -49,21 +49,34 @@ SOFTWARE.
 #include "ob/text.hh"
 #include "ob/term.hh"
 #include "ob/prism.hh"
+#include "ob/triple.hh"
+#include "ob/pool.hh"
+
+#include "app/asciicast.hh"
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
 
 #include <cmath>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
+#include <array>
+#include <atomic>
 #include <tuple>
 #include <deque>
 #include <regex>
 #include <chrono>
 #include <limits>
+#include <mutex>
 #include <memory>
 #include <string>
 #include <thread>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <complex>
 #include <utility>
@@ -72,6 +85,9 @@ SOFTWARE.
 #include <sstream>
 #include <algorithm>
 #include <functional>
+#include <optional>
+#include <exception>
+#include <condition_variable>
 #include <unordered_map>
 
 namespace aec = OB::Term::ANSI_Escape_Codes;
@@ -311,6 +327,8 @@ Vec2n<T> round(Vec2n<T> obj) {
 
 using Pos = Vec2n<std::size_t>;
 using Size = Vec2n<std::size_t>;
+// signed position, may lie partly outside a buffer
+using Point = Vec2n<std::ptrdiff_t>;
 using Vec2f = Vec2n<float>;
 
 struct Style {
@@ -345,14 +363,102 @@ inline std::ostream& operator<<(std::ostream& os, Style const& obj) {
   return os;
 }
 
+class Glyph {
+public:
+  // largest grapheme stored inline, longer ones are interned
+  static std::size_t constexpr capacity {7};
+
+  Glyph() = default;
+  Glyph(char const* str);
+  Glyph(std::string const& str);
+  Glyph(std::string_view const str);
+  Glyph(std::string_view const str, std::size_t const cols);
+  Glyph(Glyph&&) = default;
+  Glyph(Glyph const&) = default;
+  ~Glyph() = default;
+  Glyph& operator=(Glyph&&) = default;
+  Glyph& operator=(Glyph const&) = default;
+  friend bool operator==(Glyph const& lhs, Glyph const& rhs);
+  friend bool operator!=(Glyph const& lhs, Glyph const& rhs);
+  friend std::ostream& operator<<(std::ostream& os, Glyph const& obj);
+
+  std::string_view str() const;
+  std::size_t size() const;
+  std::size_t cols() const;
+  bool empty() const;
+  std::uint64_t value() const;
+
+private:
+  enum Meta : std::uint8_t {
+    Size_mask = 0x07,
+    Cols_mask = 0x18,
+    Cols_shift = 3,
+    Interned = 0x80,
+  };
+
+  void assign(std::string_view const str, std::size_t const cols);
+
+  // utf-8 bytes, or an intern table id when the interned bit is set
+  char _bytes[capacity] {' '};
+  // size in bits 0-2, columns in bits 3-4, interned flag in bit 7
+  std::uint8_t _meta {1 | (1 << 3)};
+}; // class Glyph
+static_assert(sizeof(Glyph) == sizeof(std::uint64_t));
+
+inline bool operator==(Glyph const& lhs, Glyph const& rhs) {
+  return lhs.value() == rhs.value();
+}
+
+inline bool operator!=(Glyph const& lhs, Glyph const& rhs) {
+  return lhs.value() != rhs.value();
+}
+
+inline std::ostream& operator<<(std::ostream& os, Glyph const& obj) {
+  os << obj.str();
+  return os;
+}
+
+inline std::uint64_t Glyph::value() const {
+  std::uint64_t val;
+  std::memcpy(&val, this, sizeof(val));
+  return val;
+}
+
 struct Cell {
   int zidx;
   Style style;
-  std::string text {" "};
+  Glyph text;
 };
+static_assert(std::is_trivially_copyable_v<Cell>);
+
+// a string segmented and measured once, for text that is drawn again and again
+class Prepared_text {
+public:
+  Prepared_text() = default;
+  Prepared_text(std::string_view const str);
+
+  std::string const& str() const;
+  std::vector<Glyph> const& glyphs() const;
+  std::size_t cols() const;
+
+private:
+  std::string _str;
+  std::vector<Glyph> _glyphs;
+  std::size_t _cols {0};
+}; // class Prepared_text
+
+// colours of a run of cells composited together, see window.cc
+class Over;
 
 class Buffer {
 public:
+  // columns [begin, end) of a row written since the last reset
+  struct Span {
+    std::size_t begin {0};
+    std::size_t end {0};
+    bool empty() const {return begin >= end;}
+  };
+
   Buffer(Size const size, Cell const& cell = {});
   Buffer() = default;
   Buffer(Buffer&&) = default;
@@ -362,51 +468,170 @@ public:
   Buffer& operator=(Buffer const&) = default;
   void operator()(Pos const pos, Cell const& cell);
   void operator()(Cell const& cell);
-  void put(Pos const pos, Cell const& cell);
-  void put(Cell const& cell);
+  void put(Pos const pos, std::string_view const str, Style const& style, int const zidx = 1);
+  void put(std::string_view const str, Style const& style, int const zidx = 1);
+  void put(Pos const pos, Prepared_text const& text, Style const& style, int const zidx = 1);
+  void put(Prepared_text const& text, Style const& style, int const zidx = 1);
+  // world coordinates, clipped once, then composite the same cell over a run
+  void fill_span(Point const pos, std::size_t const cols, Cell const& cell);
+  void fill_rect(Point const pos, Size const size, Cell const& cell);
+  // screen coordinates, origin top left
+  // writes through at, operator[], row and data are not tracked as dirty
   Cell& at(Pos const pos);
   Cell const& at(Pos const pos) const;
-  std::vector<Cell>& row(std::size_t const y);
-  std::vector<Cell> const& row(std::size_t const y) const;
+  Cell& operator[](Pos const pos);
+  Cell const& operator[](Pos const pos) const;
+  // world coordinates, origin bottom left
+  Cell* row(std::size_t const y);
+  Cell const* row(std::size_t const y) const;
   Cell& col(Pos const pos);
   Cell const& col(Pos const pos) const;
+  Cell* data();
+  Cell const* data() const;
+  std::size_t stride() const;
   Pos cursor() const;
   void cursor(Pos const pos);
   Size size() const;
   void size(Size const size, Cell const& cell = {});
+  void reset(Cell const& cell = {});
+  // reset only the cells written since the last reset, for sparse buffers
+  void erase(Cell const& cell = {});
+  // composite the cells layer wrote over this buffer, sizes must match
+  void compose(Buffer const& layer);
+  // move stored row y left by cols, the cells coming in on the right are fill
+  void shift(std::size_t const y, std::size_t const cols, Cell const& fill = {});
+  Span dirty(std::size_t const y) const;
+  void dirty(Pos const pos, std::size_t const cols = 1);
   bool empty() const;
   void clear();
+  // cells composited onto since the last reset
+  std::size_t blended() const;
 
 private:
+  std::size_t index(Pos const pos) const;
+  // composite cell over count consecutive stored cells
+  void blend(Cell* vals, std::size_t const count, Cell const& cell);
+  // composite cell over val, the colours are blended when over is flushed
+  void blend(Cell& val, Cell const& cell, Over& over);
+  void put_glyph(Glyph const& glyph, Style const& style, int const zidx, Over& over, bool const space);
+
   Pos _pos;
   Size _size;
-  std::vector<std::vector<Cell>> _value;
+  // row-major, rows stored top to bottom
+  std::vector<Cell> _value;
+  // one span per stored row
+  std::vector<Span> _dirty;
+  std::size_t _blended {0};
 }; // class Buffer
 
+// escape encoding of frame changes, tracks where the terminal cursor is and
+// which style is active after the bytes in line
+class Encoder {
+public:
+  // diff rows [begin, end) of cur against prev
+  void rows(Buffer const& cur, Buffer const& prev, std::size_t const begin, std::size_t const end, bool const full);
+  void sgr(Style const& next, bool reset = false);
+  void cursor_set(Pos const pos);
+  void cursor_move(Cell const* cells, Pos const pos);
+  void cursor_advance(std::size_t const cols, std::size_t const width);
+  // delete cols characters at pos, the rest of the row moves left
+  void delete_chars(Cell const* cells, Pos const pos, std::size_t const cols);
+
+  std::string line;
+  Pos cursor;
+  bool cursor_valid {false};
+  // a Clear style is unknown, the next sgr starts with a reset
+  Style style;
+  std::uint8_t depth {Style::Bit_24};
+};
+
 class Window {
 public:
+  ~Window();
 
 // private:
   void winch();
   void refresh();
   void render();
+  void present(Buffer const& cur, Buffer& prev);
+  void encode(Buffer const& cur, Buffer& prev);
+  void scroll_rows(Buffer const& cur, Buffer& prev);
+  void publish();
+  void present_start();
+  void present_stop();
+  void present_loop();
+  void output(boost::asio::io_context& io);
   void write(std::string& str);
-  void render_file(std::ofstream& file);
+  void write_async();
+  void drain();
+  void render_buffer();
+  void flip();
+  void render_file(std::ofstream& file, bool const ansi);
   void write_file(std::ofstream& file, std::string& str);
-  void term_fg(std::string& str, OB::Prism::RGBA rgba);
-  void term_bg(std::string& str, OB::Prism::RGBA rgba);
 
   Size size;
-  std::size_t frames {0};
-  std::size_t bsize {0};
+  std::atomic<std::size_t> frames {0};
+  // bytes written for the last frame
+  std::atomic<std::size_t> bsize {0};
+  // write syscalls made for the last frame
+  std::atomic<std::size_t> wcount {0};
+  // time from handing the last frame to the terminal until it was all taken
+  std::atomic<std::chrono::nanoseconds> wtime {std::chrono::nanoseconds(0)};
+  // wrap each frame in synchronized output markers, dec mode 2026
+  bool sync {false};
+  // colour depth of the output, truecolor cells are quantized to the 256 or
+  // 16 colour palette below Bit_24
+  std::atomic<std::uint8_t> depth {Style::Bit_24};
+  // frames skipped while the previous one was still being written, and
+  // frames sent that carried the changes of skipped ones
+  std::size_t dropped {0};
+  std::size_t dropped_run {0};
+  std::size_t merged {0};
+  // hand finished frames to a presenter thread that diffs, encodes and writes
+  // them, render then only swaps buffers and never waits on the terminal
+  bool threaded {false};
+  OB::Triple<Buffer> queue;
+  std::thread present_thread;
+  std::mutex present_mutex;
+  std::condition_variable present_cond;
+  std::atomic<bool> present_run {false};
+  std::atomic<bool> present_failed {false};
+  std::exception_ptr present_error;
+  // tee of every frame written, as an asciicast v2 file
+  std::unique_ptr<Asciicast> record;
+  // asynchronous stdout, when set frames are written without blocking
+  std::unique_ptr<boost::asio::posix::stream_descriptor> out;
+  std::string out_buf;
+  std::size_t out_pos {0};
+  std::chrono::steady_clock::time_point out_begin;
+  bool out_busy {false};
+  // the file status flags are shared with the terminal, the shell and anything
+  // started from here, O_NONBLOCK is set for the first frame written and the
+  // flags saved by output are put back by drain
+  int out_flags {0};
+  bool out_nonblock {false};
+  // state of the terminal after the bytes written so far
+  Encoder enc;
+  // with a pool, rows of the frame are diffed in bands of band_rows, every
+  // band after the first starts from an unknown cursor and style, so the
+  // bands can be encoded apart and still give the same bytes as in order
+  static constexpr std::size_t band_rows {16};
+  std::vector<Encoder> bands;
+  std::unique_ptr<OB::Pool> pool;
   Style style_base;
-  Style style;
+  // front buffer being drawn and the last presented frame, swapped after each
+  // render, with a presenter thread buf_prev belongs to it
   Buffer buf;
   Buffer buf_prev;
-  Buffer buf_1;
-  Buffer buf_2;
-  std::string line;
-  bool clear {true};
+  // compare every cell instead of only the dirty spans, a debug cross-check
+  bool diff_full {false};
+  // rows whose content moved left up to scroll_max columns are shifted on the
+  // terminal with delete character, then only what the shift missed is drawn
+  bool scroll {false};
+  static constexpr std::size_t scroll_max {4};
+  // rows shifted instead of redrawn
+  std::atomic<std::size_t> scrolled {0};
+  std::atomic<bool> clear {true};
 };
 
 #endif // WINDOW_HH
@@ -63,7 +63,8 @@ inline void program_init(OB::Parg& pg) {
   pg.name("floatybox").version("0.1.0 (15.10.2020)");
   pg.description("Float your way through perilous terrain in this endless side-scoller game.");
 
-  pg.usage("");
+  pg.usage("[--sync] [--threaded] [--threads=<n>] [--adaptive] [--budget=<n>] [--colour-depth=<24|8|4|auto>] [--record=<file>] [--scroll]");
+  pg.usage("--headless [--frames=<n>] [--size=<w>x<h>] [--output=<file>] [--format=<text|ansi>] [--seed=<n>] [--threads=<n>] [--diff-full] [--scroll]");
   pg.usage("[--colour=<on|off|auto>] -h|--help");
   pg.usage("[--colour=<on|off|auto>] -v|--version");
   pg.usage("[--colour=<on|off|auto>] --license");
@@ -76,6 +77,7 @@ inline void program_init(OB::Parg& pg) {
     {"<mouse-left>, <up>, <space>, w, k", "increase velocity"},
     {"?", "show key bindings"},
     {"c", "toggle enable/disable colour"},
+    {"i", "toggle render stats"},
     {"s", "super slow-motion"},
     {"d", "slow-motion"},
     {"??????????", "secret 1"},
@@ -118,9 +120,24 @@ inline void program_init(OB::Parg& pg) {
   pg.set("help,h", "Print the help output.");
   pg.set("version,v", "Print the program version.");
   pg.set("license", "Print the program license.");
+  pg.set("sync", "Wrap each frame in synchronized output markers, for terminals that support dec mode 2026.");
+  pg.set("threaded", "Diff, encode and write frames on a dedicated presenter thread, so the game loop never waits on the terminal.");
+  pg.set("headless", "Run without a terminal at a fixed size for a set number of frames, then print timing stats and exit.");
+  pg.set("diff-full", "Compare every cell of each frame instead of only the spans drawn to, a cross-check and the worst case for the diff.");
+  pg.set("scroll", "Shift rows whose content moved left with delete character, then draw only what the shift did not cover, instead of redrawing every moved cell.");
+  pg.set("adaptive", "Lower the render quality while the terminal can not keep up, giving up alpha fades, then colour depth, then frame rate, and raise it again once output drains freely.");
 
   // options
   pg.set("colour", "auto", "on|off|auto", "Print the program output with colour either on, off, or auto based on if stdout is a tty, the default value is 'auto'.");
+  pg.set("budget", "1048576", "n", "Bytes per second of output the adaptive quality keeps each frame under, spread over the frames of a second, at least '1', the default value is '1048576'.");
+  pg.set("colour-depth", "auto", "24|8|4|auto", "Colour depth of the game output, truecolor, the 256 colour palette or the 16 colour palette, auto picks one from the COLORTERM and TERM environment variables, or 24 in headless mode, the default value is 'auto'.");
+  pg.set("frames", "300", "n", "Number of frames to render in headless mode, the default value is '300'.");
+  pg.set("size", "80x24", "wxh", "Screen size in headless mode, at least '12x17', the default value is '80x24'.");
+  pg.set("output", "", "file", "Write headless frames to a file, without it frames are only kept in memory.");
+  pg.set("format", "text", "text|ansi", "Format of the headless output file, plain text rows or the escape sequences a terminal would get, the default value is 'text'.");
+  pg.set("threads", "1", "n", "Threads that diff and encode the bands of each frame, 0 uses one per core, the output is the same for any count, the default value is '1'.");
+  pg.set("record", "", "file", "Record the session as an asciicast v2 file, every frame exactly as it was written to the terminal.");
+  pg.set("seed", "0", "n", "Seed for the terrain, for repeatable runs.");
 
   // allow and capture positional arguments
   // pg.set_pos();
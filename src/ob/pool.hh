@@ -0,0 +1,161 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OB_POOL_HH
+#define OB_POOL_HH
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+namespace OB {
+
+// fixed set of worker threads that split a batch of indexed jobs with the
+// calling thread, run returns once every job of the batch is done
+class Pool {
+public:
+
+  explicit Pool(std::size_t const threads) {
+    // the calling thread is one of them
+    for (std::size_t i = 1; i < threads; ++i) {
+      _threads.emplace_back([&]() {work();});
+    }
+  }
+
+  Pool(Pool const&) = delete;
+
+  Pool& operator=(Pool const&) = delete;
+
+  ~Pool() {
+    {
+      std::lock_guard<std::mutex> lock {_mutex};
+      _stop = true;
+    }
+    _cond.notify_all();
+    for (auto& thread : _threads) {
+      thread.join();
+    }
+  }
+
+  std::size_t size() const noexcept {
+    return _threads.size() + 1;
+  }
+
+  // call fn(i) for every i in [0, n)
+  void run(std::size_t const n, std::function<void(std::size_t)> const& fn) {
+    if (_threads.empty() || n < 2) {
+      for (std::size_t i = 0; i < n; ++i) {fn(i);}
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock {_mutex};
+      _fn = &fn;
+      _size = n;
+      _next = 0;
+      ++_batch;
+    }
+    _cond.notify_all();
+
+    take(fn, n);
+
+    // wait for workers still inside this batch, so none can carry over into
+    // the next one
+    std::unique_lock<std::mutex> lock {_mutex};
+    _done.wait(lock, [&]() {return _active == 0;});
+    _fn = nullptr;
+  }
+
+private:
+  void take(std::function<void(std::size_t)> const& fn, std::size_t const n) {
+    for (auto i = _next.fetch_add(1); i < n; i = _next.fetch_add(1)) {
+      fn(i);
+    }
+  }
+
+  void work() {
+    std::size_t batch {0};
+    for (;;) {
+      std::function<void(std::size_t)> const* fn {nullptr};
+      std::size_t n {0};
+      {
+        std::unique_lock<std::mutex> lock {_mutex};
+        _cond.wait(lock, [&]() {return _stop || (_fn && _batch != batch);});
+        if (_stop) {return;}
+        batch = _batch;
+        fn = _fn;
+        n = _size;
+        ++_active;
+      }
+
+      take(*fn, n);
+
+      {
+        std::lock_guard<std::mutex> lock {_mutex};
+        --_active;
+      }
+      _done.notify_one();
+    }
+  }
+
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _cond;
+  std::condition_variable _done;
+  std::function<void(std::size_t)> const* _fn {nullptr};
+  std::size_t _size {0};
+  std::atomic<std::size_t> _next {0};
+  std::size_t _batch {0};
+  std::size_t _active {0};
+  bool _stop {false};
+}; // class Pool
+
+} // namespace OB
+
+#endif // OB_POOL_HH
@@ -51,6 +51,10 @@ SOFTWARE.
 #include <limits>
 #include <iomanip>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 namespace OB::Prism {
 
 template<class T>
@@ -59,20 +63,8 @@ static typename std::enable_if<!std::numeric_limits<T>::is_integer, bool>::type
 }
 
 static std::string hex_encode(std::uint8_t const ch) {
-  char hex[3] {0};
-  if (ch & 0x80) {
-    std::snprintf(&hex[0], 3, "%02X", static_cast<unsigned int>(ch & 0xff));
-  }
-  else {
-    std::snprintf(&hex[0], 3, "%02X", static_cast<unsigned int>(ch));
-  }
-  return std::string(hex);
-}
-
-static std::uint8_t hex_decode(std::string_view const str) {
-  unsigned int hex {0};
-  std::sscanf(str.data(), "%02X", &hex);
-  return static_cast<std::uint8_t>(hex);
+  static constexpr char digits[] {"0123456789ABCDEF"};
+  return std::string {digits[ch >> 4], digits[ch & 0x0f]};
 }
 
 static void uppercase(std::string& str) {
@@ -238,9 +230,7 @@ Hex& Hex::from_hsla(HSLA const& hsla) {
   return from_rgba(RGBA(hsla));
 }
 
-RGBA::RGBA(std::uint8_t const r, std::uint8_t const g, std::uint8_t const b, std::uint8_t const a) : _r {r}, _g {g}, _b {b}, _a {a} {}
-
-RGBA::RGBA(int const r, int const g, int const b, double const a) : _r {static_cast<std::uint8_t>(r)}, _g {static_cast<std::uint8_t>(g)}, _b {static_cast<std::uint8_t>(b)}, _a {static_cast<std::uint8_t>(std::round(a * 255))} {}
+RGBA::RGBA(int const r, int const g, int const b, double const a) : _value {pack(static_cast<std::uint8_t>(r), static_cast<std::uint8_t>(g), static_cast<std::uint8_t>(b), static_cast<std::uint8_t>(std::round(a * 255)))} {}
 
 RGBA::RGBA(Hex&& hex) {
   from_hex(hex);
@@ -278,28 +268,41 @@ RGBA& RGBA::operator=(HSLA const& hsla) {
   return *this;
 }
 
+// divide by 255 rounding to nearest, exact for v up to 255 * 255
+static std::uint8_t div255(unsigned int const v) {
+  return static_cast<std::uint8_t>((v + 128 + ((v + 128) >> 8)) >> 8);
+}
+
 RGBA& RGBA::operator+=(RGBA const& obj) {
-  // r(((obj.r() * (obj.a() + 1)) + (r() * (256 - obj.a()))) >> 8);
-  // g(((obj.g() * (obj.a() + 1)) + (g() * (256 - obj.a()))) >> 8);
-  // b(((obj.b() * (obj.a() + 1)) + (b() * (256 - obj.a()))) >> 8);
-  // r((obj.r() * obj.a() + r() * (255 - obj.a())) / 255);
-  // g((obj.g() * obj.a() + g() * (255 - obj.a())) / 255);
-  // b((obj.b() * obj.a() + b() * (255 - obj.a())) / 255);
-  // r(((r() * a()) + (obj.r() * obj.a() * (1 - a()))) / (obj.a() + (a() * (1 - obj.a()))));
-
-  if (obj.a() == 255) {
+  // source over, straight alpha in and out, composited on premultiplied values
+  unsigned int const sa {obj.a()};
+
+  if (sa == 255 || a() == 0) {
     *this = obj;
     return *this;
   }
 
-  if (obj.a() == 0) {
+  if (sa == 0) {
+    return *this;
+  }
+
+  unsigned int const ia {255 - sa};
+
+  if (a() == 255) {
+    // opaque destination, the common case, the result stays opaque
+    *this = RGBA(div255(obj.r() * sa + r() * ia), div255(obj.g() * sa + g() * ia),
+      div255(obj.b() * sa + b() * ia), 255);
     return *this;
   }
 
-  r(static_cast<std::uint8_t>(((obj.r() * (obj.a() / 255.0)) + ((r() * (a() / 255.0)) * (1.0 - (obj.a() / 255.0)))) / ((obj.a() / 255.0) + ((a() / 255.0) * (1.0 - (obj.a() / 255.0))))));
-  g(static_cast<std::uint8_t>(((obj.g() * (obj.a() / 255.0)) + ((g() * (a() / 255.0)) * (1.0 - (obj.a() / 255.0)))) / ((obj.a() / 255.0) + ((a() / 255.0) * (1.0 - (obj.a() / 255.0))))));
-  b(static_cast<std::uint8_t>(((obj.b() * (obj.a() / 255.0)) + ((b() * (a() / 255.0)) * (1.0 - (obj.a() / 255.0)))) / ((obj.a() / 255.0) + ((a() / 255.0) * (1.0 - (obj.a() / 255.0))))));
-  a(static_cast<std::uint8_t>(((obj.a() / 255.0) + ((a() / 255.0) * (1.0 - (obj.a() / 255.0)))) * 255));
+  // share of the destination left showing, then back to straight alpha
+  unsigned int const da {div255(a() * ia)};
+  unsigned int const oa {sa + da};
+  auto const channel = [&](unsigned int const src, unsigned int const dst) {
+    return static_cast<std::uint8_t>((src * sa + dst * da + oa / 2) / oa);
+  };
+  *this = RGBA(channel(obj.r(), r()), channel(obj.g(), g()), channel(obj.b(), b()),
+    static_cast<std::uint8_t>(oa));
 
   return *this;
 }
@@ -308,40 +311,80 @@ RGBA operator+(RGBA lhs, RGBA const& rhs) {
   return lhs += rhs;
 }
 
-bool operator<(RGBA const& lhs, RGBA const& rhs) {
-  auto lr = lhs.r();
-  auto lg = lhs.g();
-  auto lb = lhs.b();
-  auto la = lhs.a();
-  auto rr = rhs.r();
-  auto rg = rhs.g();
-  auto rb = rhs.b();
-  auto ra = rhs.a();
-  return std::tie(lr, lg, lb, la) < std::tie(rr, rg, rb, ra);
-}
-
-bool operator==(RGBA const& lhs, RGBA const& rhs) {
-  auto lr = lhs.r();
-  auto lg = lhs.g();
-  auto lb = lhs.b();
-  auto la = lhs.a();
-  auto rr = rhs.r();
-  auto rg = rhs.g();
-  auto rb = rhs.b();
-  auto ra = rhs.a();
-  return std::tie(lr, lg, lb, la) == std::tie(rr, rg, rb, ra);
+void blend(RGBA* dst, RGBA const* src, std::size_t const count) {
+  std::size_t i {0};
+#if defined(__SSE2__)
+  auto const zero = _mm_setzero_si128();
+  auto const max = _mm_set1_epi16(255);
+  auto const half = _mm_set1_epi16(128);
+  auto const alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+  auto const over = [&](__m128i const d, __m128i const s) {
+    // each source alpha spread across the lanes of its colour
+    auto const sa = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    auto v = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, sa), _mm_mullo_epi16(d, _mm_sub_epi16(max, sa))), half);
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+  };
+  // four colours per step, widened to 16 bit lanes two at a time
+  for (; i + 4 <= count; i += 4) {
+    if (((dst[i].value() & dst[i + 1].value() & dst[i + 2].value() & dst[i + 3].value()) >> 24) != 255) {
+      // a translucent destination needs the straight alpha division
+      for (auto j = i; j < i + 4; ++j) {
+        dst[j] += src[j];
+      }
+      continue;
+    }
+    auto const d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&dst[i]));
+    auto const s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&src[i]));
+    auto const lo = over(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+    auto const hi = over(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[i]), _mm_or_si128(_mm_packus_epi16(lo, hi), alpha));
+  }
+  // then two
+  for (; i + 2 <= count; i += 2) {
+    if (((dst[i].value() & dst[i + 1].value()) >> 24) != 255) {
+      // a translucent destination needs the straight alpha division
+      dst[i] += src[i];
+      dst[i + 1] += src[i + 1];
+      continue;
+    }
+    auto const d = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(&dst[i])), zero);
+    auto const s = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(&src[i])), zero);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&dst[i]), _mm_or_si128(_mm_packus_epi16(over(d, s), zero), alpha));
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i] += src[i];
+  }
 }
 
-bool operator!=(RGBA const& lhs, RGBA const& rhs) {
-  auto lr = lhs.r();
-  auto lg = lhs.g();
-  auto lb = lhs.b();
-  auto la = lhs.a();
-  auto rr = rhs.r();
-  auto rg = rhs.g();
-  auto rb = rhs.b();
-  auto ra = rhs.a();
-  return std::tie(lr, lg, lb, la) != std::tie(rr, rg, rb, ra);
+void lerp(RGBA* dst, RGBA const* lhs, RGBA const* rhs, std::size_t const count, std::uint8_t const t) {
+  unsigned int const wr {t};
+  unsigned int const wl {255u - t};
+  std::size_t i {0};
+#if defined(__SSE2__)
+  auto const zero = _mm_setzero_si128();
+  auto const half = _mm_set1_epi16(128);
+  auto const vl = _mm_set1_epi16(static_cast<short>(wl));
+  auto const vr = _mm_set1_epi16(static_cast<short>(wr));
+  auto const mix = [&](__m128i const l, __m128i const r) {
+    auto v = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(l, vl), _mm_mullo_epi16(r, vr)), half);
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+  };
+  // four colours per step
+  for (; i + 4 <= count; i += 4) {
+    auto const l = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&lhs[i]));
+    auto const r = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&rhs[i]));
+    auto const lo = mix(_mm_unpacklo_epi8(l, zero), _mm_unpacklo_epi8(r, zero));
+    auto const hi = mix(_mm_unpackhi_epi8(l, zero), _mm_unpackhi_epi8(r, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[i]), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < count; ++i) {
+    auto const l = lhs[i];
+    auto const r = rhs[i];
+    dst[i] = RGBA(div255(l.r() * wl + r.r() * wr), div255(l.g() * wl + r.g() * wr),
+      div255(l.b() * wl + r.b() * wr), div255(l.a() * wl + r.a() * wr));
+  }
 }
 
 std::ostream& operator<<(std::ostream& os, RGBA const& obj) {
@@ -349,76 +392,9 @@ std::ostream& operator<<(std::ostream& os, RGBA const& obj) {
   return os;
 }
 
-std::uint8_t RGBA::r() const {
-  return _r;
-}
-
-RGBA& RGBA::r(std::uint8_t const v) {
-  _r = v;
-  return *this;
-}
-
-std::uint8_t RGBA::g() const {
-  return _g;
-}
-
-RGBA& RGBA::g(std::uint8_t const v) {
-  _g = v;
-  return *this;
-}
-
-std::uint8_t RGBA::b() const {
-  return _b;
-}
-
-RGBA& RGBA::b(std::uint8_t const v) {
-  _b = v;
-  return *this;
-}
-
-std::uint8_t RGBA::a() const {
-  return _a;
-}
-
-RGBA& RGBA::a(std::uint8_t const v) {
-  _a = v;
-  return *this;
-}
-
 RGBA& RGBA::from_hex(Hex const& hex) {
-  switch (hex.str().size()) {
-    case 3: {
-      r(hex_decode(std::string(2, hex.str().at(0))));
-      g(hex_decode(std::string(2, hex.str().at(1))));
-      b(hex_decode(std::string(2, hex.str().at(2))));
-      a(static_cast<std::uint8_t>(255));
-      break;
-    }
-    case 4: {
-      r(hex_decode(std::string(2, hex.str().at(0))));
-      g(hex_decode(std::string(2, hex.str().at(1))));
-      b(hex_decode(std::string(2, hex.str().at(2))));
-      a(hex_decode(std::string(2, hex.str().at(3))));
-      break;
-    }
-    case 6: {
-      r(hex_decode(hex.str().substr(0, 2)));
-      g(hex_decode(hex.str().substr(2, 2)));
-      b(hex_decode(hex.str().substr(4, 2)));
-      a(static_cast<std::uint8_t>(255));
-      break;
-    }
-    case 8: {
-      r(hex_decode(hex.str().substr(0, 2)));
-      g(hex_decode(hex.str().substr(2, 2)));
-      b(hex_decode(hex.str().substr(4, 2)));
-      a(hex_decode(hex.str().substr(6, 2)));
-      break;
-    }
-    default: {
-      break;
-    }
-  }
+  // hex is always normalised to eight digits
+  *this = RGBA::hex(hex.str());
   return *this;
 }
 
@@ -54,7 +54,9 @@ SOFTWARE.
 #include <memory>
 #include <string>
 #include <iostream>
+#include <stdexcept>
 #include <string_view>
+#include <type_traits>
 
 namespace OB::Prism {
 
@@ -104,15 +106,17 @@ private:
 
 class RGBA {
 public:
-  RGBA(std::uint8_t const r, std::uint8_t const g, std::uint8_t const b, std::uint8_t const a);
+  constexpr RGBA(std::uint8_t const r, std::uint8_t const g, std::uint8_t const b, std::uint8_t const a) :
+    _value {pack(r, g, b, a)} {
+  }
   RGBA(int const r, int const g, int const b, double const a);
   RGBA(Hex&& hex);
   RGBA(Hex const& hex);
   RGBA(HSLA&& hsla);
   RGBA(HSLA const& hsla);
-  RGBA() = default;
-  RGBA(RGBA&&) = default;
-  RGBA(RGBA const&) = default;
+  constexpr RGBA() = default;
+  constexpr RGBA(RGBA&&) = default;
+  constexpr RGBA(RGBA const&) = default;
 
   ~RGBA() = default;
 
@@ -120,23 +124,47 @@ public:
   RGBA& operator=(Hex const& hex);
   RGBA& operator=(HSLA&& hsla);
   RGBA& operator=(HSLA const& hsla);
-  RGBA& operator=(RGBA&&) = default;
-  RGBA& operator=(RGBA const&) = default;
+  constexpr RGBA& operator=(RGBA&&) = default;
+  constexpr RGBA& operator=(RGBA const&) = default;
   RGBA& operator+=(RGBA const& obj);
   friend RGBA operator+(RGBA lhs, RGBA const& rhs);
-  friend bool operator<(RGBA const& lhs, RGBA const& rhs);
-  friend bool operator==(RGBA const& lhs, RGBA const& rhs);
-  friend bool operator!=(RGBA const& lhs, RGBA const& rhs);
+  friend constexpr bool operator<(RGBA const& lhs, RGBA const& rhs);
+  friend constexpr bool operator==(RGBA const& lhs, RGBA const& rhs);
+  friend constexpr bool operator!=(RGBA const& lhs, RGBA const& rhs);
   friend std::ostream& operator<<(std::ostream& os, RGBA const& obj);
 
-  std::uint8_t r() const;
-  RGBA& r(std::uint8_t const v);
-  std::uint8_t g() const;
-  RGBA& g(std::uint8_t const v);
-  std::uint8_t b() const;
-  RGBA& b(std::uint8_t const v);
-  std::uint8_t a() const;
-  RGBA& a(std::uint8_t const v);
+  // rgb, rgba, rrggbb or rrggbbaa hex digits, without alpha it is opaque
+  static constexpr RGBA hex(std::string_view const str) {
+    switch (str.size()) {
+      case 3: {
+        return RGBA(digit(str[0]), digit(str[1]), digit(str[2]), std::uint8_t {255});
+      }
+      case 4: {
+        return RGBA(digit(str[0]), digit(str[1]), digit(str[2]), digit(str[3]));
+      }
+      case 6: {
+        return RGBA(byte(str, 0), byte(str, 2), byte(str, 4), std::uint8_t {255});
+      }
+      case 8: {
+        return RGBA(byte(str, 0), byte(str, 2), byte(str, 4), byte(str, 6));
+      }
+      default: {
+        throw std::runtime_error("failed to convert string to Color::RGBA");
+      }
+    }
+  }
+
+  // the four channels as one integer, r in the low byte and a in the high
+  constexpr std::uint32_t value() const {return _value;}
+  constexpr RGBA& value(std::uint32_t const v) {_value = v; return *this;}
+  constexpr std::uint8_t r() const {return static_cast<std::uint8_t>(_value);}
+  constexpr RGBA& r(std::uint8_t const v) {return channel(0, v);}
+  constexpr std::uint8_t g() const {return static_cast<std::uint8_t>(_value >> 8);}
+  constexpr RGBA& g(std::uint8_t const v) {return channel(8, v);}
+  constexpr std::uint8_t b() const {return static_cast<std::uint8_t>(_value >> 16);}
+  constexpr RGBA& b(std::uint8_t const v) {return channel(16, v);}
+  constexpr std::uint8_t a() const {return static_cast<std::uint8_t>(_value >> 24);}
+  constexpr RGBA& a(std::uint8_t const v) {return channel(24, v);}
 
   RGBA& from_hex(Hex const& hex);
   RGBA& from_hsla(HSLA const& hsla);
@@ -144,11 +172,63 @@ public:
 private:
   float from_hue(float j, float i, float h) const;
 
-  std::uint8_t _r {0};
-  std::uint8_t _g {0};
-  std::uint8_t _b {0};
-  std::uint8_t _a {0};
+  static constexpr std::uint32_t pack(std::uint8_t const r, std::uint8_t const g, std::uint8_t const b, std::uint8_t const a) {
+    return static_cast<std::uint32_t>(r) | (static_cast<std::uint32_t>(g) << 8) |
+      (static_cast<std::uint32_t>(b) << 16) | (static_cast<std::uint32_t>(a) << 24);
+  }
+
+  static constexpr std::uint8_t nibble(char const c) {
+    if (c >= '0' && c <= '9') {return static_cast<std::uint8_t>(c - '0');}
+    if (c >= 'a' && c <= 'f') {return static_cast<std::uint8_t>(c - 'a' + 10);}
+    if (c >= 'A' && c <= 'F') {return static_cast<std::uint8_t>(c - 'A' + 10);}
+    throw std::runtime_error("failed to convert string to Color::RGBA");
+  }
+
+  // a single digit channel, f is ff
+  static constexpr std::uint8_t digit(char const c) {
+    return static_cast<std::uint8_t>(nibble(c) * 17);
+  }
+
+  static constexpr std::uint8_t byte(std::string_view const str, std::size_t const i) {
+    return static_cast<std::uint8_t>((nibble(str[i]) << 4) | nibble(str[i + 1]));
+  }
+
+  constexpr RGBA& channel(unsigned int const shift, std::uint8_t const v) {
+    _value = (_value & ~(std::uint32_t {0xff} << shift)) | (static_cast<std::uint32_t>(v) << shift);
+    return *this;
+  }
+
+  // in memory the bytes are r g b a on little endian targets
+  std::uint32_t _value {0};
 };
+static_assert(sizeof(RGBA) == sizeof(std::uint32_t) && std::is_trivially_copyable_v<RGBA>);
+static_assert(RGBA::hex("abc").value() == 0xffccbbaa);
+static_assert(RGBA::hex("abcd").value() == 0xddccbbaa);
+static_assert(RGBA::hex("1b1e24").value() == 0xff241e1b);
+static_assert(RGBA::hex("1B1E2480").value() == 0x80241e1b);
+
+constexpr bool operator<(RGBA const& lhs, RGBA const& rhs) {
+  // ordered by r, then g, b and a
+  auto const key = [](RGBA const& obj) {
+    return (static_cast<std::uint32_t>(obj.r()) << 24) | (static_cast<std::uint32_t>(obj.g()) << 16) |
+      (static_cast<std::uint32_t>(obj.b()) << 8) | obj.a();
+  };
+  return key(lhs) < key(rhs);
+}
+
+constexpr bool operator==(RGBA const& lhs, RGBA const& rhs) {
+  return lhs._value == rhs._value;
+}
+
+constexpr bool operator!=(RGBA const& lhs, RGBA const& rhs) {
+  return lhs._value != rhs._value;
+}
+
+// source over of src onto dst for count colours, as dst[i] += src[i]
+void blend(RGBA* dst, RGBA const* src, std::size_t const count);
+
+// dst[i] = lhs[i] + (rhs[i] - lhs[i]) * t / 255 on every channel
+void lerp(RGBA* dst, RGBA const* lhs, RGBA const* rhs, std::size_t const count, std::uint8_t const t);
 
 class HSLA {
 public:
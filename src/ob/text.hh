@@ -48,9 +48,12 @@ SOFTWARE.
 
 #define U_CHARSET_IS_UTF8 1
 
+#include "ob/width.hh"
+
 #include <unicode/coll.h>
 #include <unicode/regex.h>
 #include <unicode/utext.h>
+#include <unicode/utf8.h>
 #include <unicode/unistr.h>
 #include <unicode/brkiter.h>
 #include <unicode/bytestream.h>
@@ -174,26 +177,49 @@ public:
       return *this;
     }
 
-    UErrorCode ec = U_ZERO_ERROR;
+    // plain ascii, every byte is its own single column grapheme, except a
+    // carriage return line feed pair which ends up as one
+    if (std::all_of(str.begin(), str.end(), [](char_type const ch) {
+      return static_cast<unsigned char>(ch) < 0x80 && ch != '\r';}))
+    {
+      _view.reserve(str.size());
+      for (size_type i = 0; i < str.size(); ++i)
+      {
+        _view.emplace_back(i, i, 1, string_view(str.data() + i, 1));
+      }
+      _cols = str.size();
+      _bytes = str.size();
 
-    std::unique_ptr<UText, decltype(&utext_close)> text (
-      utext_openUTF8(nullptr, str.data(), static_cast<std::int64_t>(str.size()), &ec),
-      utext_close);
+      return *this;
+    }
 
-    if (U_FAILURE(ec))
+    // a single code point is a single grapheme
     {
-      throw std::runtime_error("failed to create utext");
+      std::int32_t i {0};
+      UChar32 uch;
+      U8_NEXT(reinterpret_cast<std::uint8_t const*>(str.data()), i, static_cast<std::int32_t>(str.size()), uch);
+      if (uch >= 0 && static_cast<size_type>(i) == str.size())
+      {
+        _view.emplace_back(0, 0, Text::width(static_cast<char32_t>(uch)), str);
+        _cols = _view.back().cols;
+        _bytes = str.size();
+
+        return *this;
+      }
     }
 
-    std::unique_ptr<brk_iter> iter {brk_iter::createCharacterInstance(
-      locale::getDefault(), ec)};
+    UErrorCode ec = U_ZERO_ERROR;
+
+    auto& cache = Brk::get();
+    auto* text = utext_openUTF8(&cache.text, str.data(), static_cast<std::int64_t>(str.size()), &ec);
 
     if (U_FAILURE(ec))
     {
-      throw std::runtime_error("failed to create break iterator");
+      throw std::runtime_error("failed to create utext");
     }
 
-    iter->setText(text.get(), ec);
+    auto& iter = cache.iter;
+    iter->setText(text, ec);
 
     if (U_FAILURE(ec))
     {
@@ -212,7 +238,6 @@ public:
 
     size = 0;
     UChar32 uch;
-    int width {0};
     size_type cols {0};
     auto begin = iter->first();
     auto end = iter->next();
@@ -220,18 +245,8 @@ public:
     while (end != iter_end)
     {
       // get column width
-      uch = utext_char32At(text.get(), begin);
-      width = u_getIntPropertyValue(uch, UCHAR_EAST_ASIAN_WIDTH);
-      if (width == U_EA_FULLWIDTH || width == U_EA_WIDE)
-      {
-        // full width
-        cols = 2;
-      }
-      else
-      {
-        // half width
-        cols = 1;
-      }
+      uch = utext_char32At(text, begin);
+      cols = Text::width(static_cast<char32_t>(uch));
 
       // get string size
       size = static_cast<size_type>(end - begin);
@@ -693,6 +708,37 @@ public:
 
 private:
 
+  // break iterator and utext reused by every view built on a thread, creating
+  // the iterator costs far more than segmenting a short string
+  struct Brk
+  {
+    Brk()
+    {
+      UErrorCode ec = U_ZERO_ERROR;
+      iter.reset(brk_iter::createCharacterInstance(locale::getDefault(), ec));
+
+      if (U_FAILURE(ec))
+      {
+        throw std::runtime_error("failed to create break iterator");
+      }
+    }
+
+    ~Brk()
+    {
+      utext_close(&text);
+    }
+
+    static Brk& get()
+    {
+      thread_local Brk brk;
+
+      return brk;
+    }
+
+    std::unique_ptr<brk_iter> iter;
+    UText text = UTEXT_INITIALIZER;
+  }; // struct Brk
+
   // array of contexts mapping the string
   value_type _view;
 
@@ -0,0 +1,111 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef OB_TRIPLE_HH
+#define OB_TRIPLE_HH
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace OB {
+
+// single producer single consumer triple buffer, neither side ever waits on
+// the other, a value not yet taken by the consumer is replaced by the next one
+template<typename T>
+class Triple {
+public:
+
+  Triple() = default;
+
+  Triple(Triple const&) = delete;
+
+  Triple& operator=(Triple const&) = delete;
+
+  // slot owned by the producer
+  T& back() noexcept {
+    return _value[_back];
+  }
+
+  // hand the back slot to the consumer and take the middle one in exchange,
+  // returns false if the value it replaced was never taken
+  bool publish() noexcept {
+    auto const prev = _state.exchange(static_cast<std::uint8_t>(_back | Fresh), std::memory_order_acq_rel);
+    _back = prev & Index;
+    return !(prev & Fresh);
+  }
+
+  // a published value is waiting for the consumer
+  bool pending() const noexcept {
+    return _state.load(std::memory_order_acquire) & Fresh;
+  }
+
+  // take the newest value into the front slot, returns false if there is none
+  bool acquire() noexcept {
+    if (!pending()) {return false;}
+    auto const prev = _state.exchange(_front, std::memory_order_acq_rel);
+    _front = prev & Index;
+    return true;
+  }
+
+  // slot owned by the consumer
+  T& front() noexcept {
+    return _value[_front];
+  }
+
+private:
+  static constexpr std::uint8_t Index {0x03};
+  static constexpr std::uint8_t Fresh {0x04};
+
+  std::array<T, 3> _value;
+  std::uint8_t _back {0};
+  std::uint8_t _front {2};
+  // index of the middle slot and whether it holds an unread value
+  std::atomic<std::uint8_t> _state {1};
+}; // class Triple
+
+} // namespace OB
+
+#endif // OB_TRIPLE_HH
@@ -0,0 +1,134 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "info.hh"
+#include "app/app.hh"
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+// the adaptive quality controller fed frames of a set size, with no write
+// latency, drops or overruns, so the bytes per frame are all it goes on
+struct App_test {
+  App app;
+
+  explicit App_test(OB::Parg& pg) : app {pg} {
+    app._headless = true;
+    app._adaptive = true;
+    app._width = 80;
+    app._height = 24;
+    app._fixed_size = true;
+    app.window_init();
+    app._win.size = {app._width, app._height};
+    app._win.winch();
+    // 30 fps, a thousand bytes for each frame
+    app._budget = 30000.0;
+  }
+
+  // run frames of size bytes until the trend settles, then long enough for
+  // the controller to act on it, and return the quality level it picked
+  std::size_t frames(std::size_t const size) {
+    for (std::size_t i = 0; i < 64; ++i) {
+      frame(size);
+    }
+    app._trend_begin -= 10s;
+    frame(size);
+    return app._quality;
+  }
+
+  void quality(std::size_t const level) {
+    app.quality(level);
+  }
+
+  void frame(std::size_t const size) {
+    app._win.bsize = size;
+    app._tick_end = Clock::now();
+    app.adapt();
+  }
+};
+
+int main() {
+  std::vector<char const*> args {"floatybox", "--headless"};
+  OB::Parg pg {static_cast<int>(args.size()), const_cast<char**>(args.data())};
+  if (program_info(pg) != 0) {return EXIT_FAILURE;}
+
+  {
+    // over the budget steps down
+    App_test test {pg};
+    TEST_CHECK(test.frames(1500) == 1);
+    TEST_CHECK(test.frames(1500) == 2);
+  }
+
+  {
+    // well under it steps back up
+    App_test test {pg};
+    test.quality(2);
+    TEST_CHECK(test.frames(200) == 1);
+  }
+
+  {
+    // between half the budget and all of it holds
+    App_test test {pg};
+    test.quality(2);
+    TEST_CHECK(test.frames(700) == 2);
+    TEST_CHECK(test.frames(999) == 2);
+  }
+
+  {
+    // a lower frame rate gives each frame a bigger share of the budget
+    App_test test {pg};
+    test.quality(3);
+    TEST_CHECK(test.frames(1500) == 4);
+    TEST_CHECK(test.frames(1500) == 4);
+  }
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "info.hh"
+#include "app/app.hh"
+#include "app/window.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <new>
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+// every call to the global allocator, counted from here on
+static std::size_t allocations {0};
+
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* ptr = std::malloc(size ? size : 1)) {return ptr;}
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+// a scene that changes every frame and repeats every period frames, bars
+// moving across the screen, a row of text and a counter
+static constexpr std::size_t period {64};
+
+static void draw(Buffer& buf, std::size_t const frame) {
+  auto const i = frame % period;
+  Style const box {Style::Bit_24, 0, OB::Prism::RGBA::hex("df6c3e"), OB::Prism::RGBA::hex("1b1e24")};
+  Style const faded {Style::Bit_24, 0, OB::Prism::RGBA::hex("61afef80"), OB::Prism::RGBA::hex("1b1e24")};
+  static Prepared_text const title {"FLOATYBOX v0.1.0"};
+  static std::array<Glyph, 8> const bar {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+
+  buf.fill_rect(Point{static_cast<std::ptrdiff_t>(i), 2}, Size{4, 8 + i % 5}, Cell{1, box, bar[7]});
+  buf.fill_span(Point{static_cast<std::ptrdiff_t>(i), 10 + static_cast<std::ptrdiff_t>(i % 5)}, 4, Cell{1, box, bar[i % 8]});
+  buf.fill_rect(Point{static_cast<std::ptrdiff_t>(period - i), 4}, Size{6, 12}, Cell{1, faded, bar[7]});
+  buf.put(Pos{0, 0}, title, box);
+  char count[8] {};
+  std::snprintf(count, sizeof(count), "%zu", i);
+  buf.put(Pos{70, 0}, std::string_view(count), box);
+}
+
+// allocations made while drawing and rendering a steady run of frames,
+// after two periods to warm up
+template<typename F>
+static std::size_t steady(Window& win, F const& render) {
+  win.size = {80, 24};
+  win.winch();
+  std::size_t count {0};
+  for (std::size_t frame = 0; frame < period * 4; ++frame) {
+    auto const begin = allocations;
+    draw(win.buf, frame);
+    render();
+    if (frame >= period * 2) {
+      count += allocations - begin;
+    }
+  }
+  return count;
+}
+
+// the game loop, the whole frame after the game update is counted, drawing
+// the layers, compositing them, encoding and writing the output, the game
+// does not repeat, so it warms up until the output buffers reach their peak
+struct App_test {
+  enum class Output {Terminal, Ansi, Text};
+
+  static std::size_t steady(std::vector<char const*> args, Output const output, bool const stats, bool const color) {
+    args.insert(args.begin(), "floatybox");
+    args.emplace_back("--headless");
+    OB::Parg pg {static_cast<int>(args.size()), const_cast<char**>(args.data())};
+    if (program_info(pg) != 0) {return ~std::size_t{0};}
+
+    App app {pg};
+    app._headless = true;
+    app._width = 80;
+    app._height = 24;
+    app._fixed_size = true;
+    app._cfg.color = color;
+    app.window_init();
+    app._win.sync = pg.find("sync");
+    app._win.size = {app._width, app._height};
+    app._win.winch();
+    app._state = {};
+    app._state.seed = 7;
+    app.game_init();
+    app._show_stats = stats;
+
+    double const dt = std::chrono::duration<double>(app._timestep).count();
+    app._fps_actual = app._cfg.fps;
+    std::ofstream file {"/dev/null", std::ios::binary};
+    std::size_t count {0};
+    for (std::size_t frame = 0; frame < period * 20; ++frame) {
+      app.advance(dt);
+      auto const begin = allocations;
+      app.draw();
+      if (output == Output::Terminal) {
+        app._win.render();
+      }
+      else {
+        app._win.render_file(file, output == Output::Ansi);
+      }
+      if (frame >= period * 16) {
+        count += allocations - begin;
+      }
+    }
+    return count;
+  }
+};
+
+int main() {
+  auto const base = Style{Style::Bit_24, Style::Null, OB::Prism::RGBA::hex("1b1e24"), OB::Prism::RGBA::hex("1b1e24")};
+
+  // the terminal path writes to stdout, keep it out of the test log
+  auto const null = ::open("/dev/null", O_WRONLY);
+  ::dup2(null, STDOUT_FILENO);
+  ::close(null);
+
+  {
+    Window win;
+    win.style_base = base;
+    auto const count = steady(win, [&]() {win.render();});
+    std::cerr << "draw render: " << count << " allocations\n";
+    TEST_CHECK(count == 0);
+  }
+
+  {
+    Window win;
+    win.style_base = base;
+    win.scroll = true;
+    win.depth = Style::Bit_8;
+    auto const count = steady(win, [&]() {win.render();});
+    std::cerr << "draw render scroll 256 colour: " << count << " allocations\n";
+    TEST_CHECK(count == 0);
+  }
+
+  for (auto const ansi : {true, false}) {
+    std::ofstream file {"/dev/null", std::ios::binary};
+    Window win;
+    win.style_base = base;
+    auto const count = steady(win, [&]() {win.render_file(file, ansi);});
+    std::cerr << "draw render_file " << (ansi ? "ansi" : "text") << ": " << count << " allocations\n";
+    TEST_CHECK(count == 0);
+  }
+
+  using Output = App_test::Output;
+  struct {
+    char const* name;
+    std::vector<char const*> args;
+    Output output;
+    bool stats;
+    bool color;
+  } const frames[] {
+    {"frame terminal", {}, Output::Terminal, false, true},
+    {"frame terminal stats", {"--threads=1"}, Output::Terminal, true, true},
+    {"frame terminal sync", {"--sync"}, Output::Terminal, false, true},
+    {"frame ansi", {}, Output::Ansi, false, true},
+    {"frame text", {}, Output::Text, false, true},
+    {"frame stats", {}, Output::Ansi, true, true},
+    {"frame no colour", {}, Output::Ansi, false, false},
+    {"frame scroll 256 colour", {"--scroll", "--colour-depth=8"}, Output::Terminal, false, true},
+    {"frame threads", {"--threads=4"}, Output::Ansi, true, true},
+  };
+  for (auto const& e : frames) {
+    auto const count = App_test::steady(e.args, e.output, e.stats, e.color);
+    std::cerr << e.name << ": " << count << " allocations\n";
+    TEST_CHECK(count == 0);
+  }
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
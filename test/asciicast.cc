@@ -0,0 +1,173 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "app/asciicast.hh"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+// an event line read back, [time, "type", "data"]
+struct Event {
+  double time {-1};
+  char type {0};
+  std::string data;
+};
+
+// the json string starting at pos, escapes undone
+static std::string json_string(std::string const& str, std::size_t pos) {
+  std::string val;
+  if (pos >= str.size() || str[pos] != '"') {return val;}
+  for (++pos; pos < str.size() && str[pos] != '"'; ++pos) {
+    if (str[pos] != '\\') {
+      val += str[pos];
+      continue;
+    }
+    switch (str[++pos]) {
+      case 'n': {val += '\n'; break;}
+      case 'r': {val += '\r'; break;}
+      case 't': {val += '\t'; break;}
+      case 'u': {val += static_cast<char>(std::stoi(str.substr(pos + 1, 4), nullptr, 16)); pos += 4; break;}
+      default: {val += str[pos]; break;}
+    }
+  }
+  return val;
+}
+
+static std::vector<std::string> lines(std::string const& path) {
+  std::ifstream file {path, std::ios::binary};
+  std::vector<std::string> vals;
+  for (std::string line; std::getline(file, line);) {vals.emplace_back(line);}
+  return vals;
+}
+
+static Event event(std::string const& line) {
+  Event val;
+  char type {0};
+  int len {0};
+  if (std::sscanf(line.c_str(), "[%lf, \"%c\", %n", &val.time, &type, &len) != 2) {return Event{};}
+  val.type = type;
+  val.data = json_string(line, static_cast<std::size_t>(len));
+  return val;
+}
+
+int main() {
+  {
+    // the header, then every event in order with its data escaped
+    ::setenv("TERM", "xterm \"quoted\" \\", 1);
+    std::string const frame {"\x1b[1;2H\x1b[38;2;1;2;3mbox \"é\"\t\\\r\n\x01"};
+    {
+      Asciicast cast {"asciicast.cast", 80, 24};
+      cast.output(frame);
+      cast.output("");
+      cast.resize(80, 24);
+      cast.resize(100, 30);
+      cast.output("done");
+    }
+    auto const vals = lines("asciicast.cast");
+    TEST_CHECK(vals.size() == 4);
+    if (vals.size() == 4) {
+      TEST_CHECK(vals[0].compare(0, 41, "{\"version\": 2, \"width\": 80, \"height\": 24,") == 0);
+      TEST_CHECK(vals[0].find("\"TERM\": \"xterm \\\"quoted\\\" \\\\\"") != std::string::npos);
+      auto const out = event(vals[1]);
+      TEST_CHECK(out.type == 'o' && out.data == frame && out.time >= 0);
+      auto const size = event(vals[2]);
+      TEST_CHECK(size.type == 'r' && size.data == "100x30" && size.time >= out.time);
+      auto const done = event(vals[3]);
+      TEST_CHECK(done.type == 'o' && done.data == "done" && done.time >= size.time);
+    }
+  }
+
+  {
+    // events from two threads all arrive, in time order
+    constexpr std::size_t count {2000};
+    {
+      Asciicast cast {"asciicast.cast", 80, 24};
+      std::thread other {[&]() {
+        for (std::size_t i = 0; i < count; ++i) {cast.output("b");}
+      }};
+      for (std::size_t i = 0; i < count; ++i) {cast.output("a");}
+      other.join();
+    }
+    auto const vals = lines("asciicast.cast");
+    TEST_CHECK(vals.size() == 1 + count * 2);
+    std::size_t a {0};
+    std::size_t b {0};
+    std::size_t order {0};
+    double time {0};
+    for (std::size_t i = 1; i < vals.size(); ++i) {
+      auto const val = event(vals[i]);
+      if (val.data == "a") {++a;}
+      if (val.data == "b") {++b;}
+      if (val.time < time) {++order;}
+      time = val.time;
+    }
+    TEST_CHECK(a == count && b == count);
+    TEST_CHECK(order == 0);
+  }
+
+  {
+    bool thrown {false};
+    try {
+      Asciicast cast {"no/such/dir/asciicast.cast", 80, 24};
+    }
+    catch (std::runtime_error const&) {
+      thrown = true;
+    }
+    TEST_CHECK(thrown);
+  }
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "app/window.hh"
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <array>
+#include <random>
+#include <string>
+#include <utility>
+#include <iostream>
+#include <string_view>
+
+using RGBA = OB::Prism::RGBA;
+
+static bool same(Buffer::Span const& lhs, Buffer::Span const& rhs) {
+  return lhs.begin == rhs.begin && lhs.end == rhs.end;
+}
+
+static bool same(Cell const& lhs, Cell const& rhs) {
+  return lhs.zidx == rhs.zidx && lhs.text == rhs.text &&
+    lhs.style.type == rhs.style.type && lhs.style.attr == rhs.style.attr &&
+    lhs.style.fg.value() == rhs.style.fg.value() && lhs.style.bg.value() == rhs.style.bg.value();
+}
+
+// every cell and every row span of the two buffers match
+static bool same(Buffer const& lhs, Buffer const& rhs) {
+  if (lhs.size() != rhs.size()) {return false;}
+  for (std::size_t y = 0; y < lhs.size().y; ++y) {
+    if (!same(lhs.dirty(y), rhs.dirty(y))) {return false;}
+    for (std::size_t x = 0; x < lhs.size().x; ++x) {
+      if (!same(lhs.at(Pos{x, y}), rhs.at(Pos{x, y}))) {return false;}
+    }
+  }
+  return true;
+}
+
+// a frame of random text, some of it wide and some translucent, over blank
+static void draw(Buffer& buf, std::mt19937& rng) {
+  static std::array<std::string_view, 5> const words {"floaty", "box", "界", "▁▂▃", "é"};
+  static std::array<Style, 3> const styles {
+    Style{Style::Bit_24, Style::Null, RGBA::hex("df6c3e"), RGBA::hex("1b1e24")},
+    Style{Style::Bit_24, Style::Bold, RGBA::hex("61afef80"), RGBA::hex("98c37980")},
+    Style{Style::Default, Style::Null, {}, {}},
+  };
+  auto const size = buf.size();
+  std::uniform_int_distribution<std::size_t> x {0, size.x - 1};
+  std::uniform_int_distribution<std::size_t> y {0, size.y - 1};
+  std::uniform_int_distribution<std::size_t> n {0, 6};
+  for (auto i = n(rng); i > 0; --i) {
+    buf.put(Pos{x(rng), y(rng)}, words[rng() % words.size()], styles[rng() % styles.size()]);
+  }
+  for (auto i = n(rng); i > 0; --i) {
+    buf.col(Pos{x(rng), y(rng)}) = Cell{1, styles[0], "#"};
+  }
+}
+
+int main() {
+  auto const base = Style{Style::Bit_24, Style::Null, RGBA::hex("1b1e24"), RGBA::hex("1b1e24")};
+  auto const ink = Style{Style::Bit_24, Style::Null, RGBA::hex("df6c3e"), RGBA::hex("1b1e24")};
+  Cell const blank {0, base, " "};
+
+  {
+    // each tracked write grows the span of its row, stored top to bottom
+    Buffer buf {Size{20, 6}, blank};
+    for (std::size_t y = 0; y < 6; ++y) {
+      TEST_CHECK(buf.dirty(y).empty());
+    }
+    buf.put(Pos{3, 0}, "abc", ink);
+    TEST_CHECK(same(buf.dirty(5), Buffer::Span{3, 6}));
+    buf(Pos{10, 5}, Cell{1, ink, "x"});
+    TEST_CHECK(same(buf.dirty(0), Buffer::Span{10, 11}));
+    buf.col(Pos{1, 0}) = Cell{1, ink, "y"};
+    TEST_CHECK(same(buf.dirty(5), Buffer::Span{1, 6}));
+    buf.fill_span(Point{-2, 2}, 4, Cell{1, ink, "z"});
+    TEST_CHECK(same(buf.dirty(3), Buffer::Span{0, 2}));
+    TEST_CHECK(buf.dirty(1).empty());
+
+    // untracked writes leave the spans alone
+    buf.at(Pos{15, 1}) = Cell{1, ink, "w"};
+    TEST_CHECK(buf.dirty(1).empty());
+
+    buf.reset(blank);
+    for (std::size_t y = 0; y < 6; ++y) {
+      TEST_CHECK(buf.dirty(y).empty());
+    }
+  }
+
+  {
+    // diffing only the spans of both frames gives the bytes of diffing every
+    // cell, across a run of frames swapped the way render swaps them
+    std::mt19937 rng {7};
+    Size const size {40, 12};
+    Buffer cur {size, blank};
+    Buffer prev {size, blank};
+    std::size_t failures {0};
+    for (std::size_t frame = 0; frame < 500; ++frame) {
+      cur.reset(blank);
+      draw(cur, rng);
+      Encoder span;
+      Encoder full;
+      span.rows(cur, prev, 0, size.y, false);
+      full.rows(cur, prev, 0, size.y, true);
+      if (span.line != full.line) {++failures;}
+      std::swap(cur, prev);
+    }
+    TEST_CHECK(failures == 0);
+  }
+
+  {
+    // a fill is the same as writing the cell to each position it covers that
+    // is on the buffer, rects hang off every edge, overlap, and sit above and
+    // below each other
+    std::mt19937 rng {11};
+    std::array<Style, 3> const styles {
+      ink,
+      Style{Style::Bit_24, Style::Underline, RGBA::hex("61afef80"), RGBA::hex("98c37940")},
+      Style{Style::Default, Style::Null, {}, {}},
+    };
+    std::array<Glyph, 2> const texts {" ", "#"};
+    Size const size {23, 9};
+    std::uniform_int_distribution<std::ptrdiff_t> x {-6, 28};
+    std::uniform_int_distribution<std::ptrdiff_t> y {-6, 14};
+    std::uniform_int_distribution<std::size_t> n {0, 9};
+    std::size_t failures {0};
+    for (std::size_t trial = 0; trial < 200; ++trial) {
+      Buffer fill {size, blank};
+      Buffer cells {size, blank};
+      for (std::size_t i = 0; i < 40; ++i) {
+        Point const pos {x(rng), y(rng)};
+        Size const area {n(rng), i % 4 == 0 ? 1 : n(rng)};
+        Cell const cell {static_cast<int>(rng() % 3), styles[rng() % styles.size()], texts[rng() % texts.size()]};
+        if (area.y == 1 && i % 8 == 0) {
+          fill.fill_span(pos, area.x, cell);
+        }
+        else {
+          fill.fill_rect(pos, area, cell);
+        }
+        for (auto cy = pos.y; cy < pos.y + static_cast<std::ptrdiff_t>(area.y); ++cy) {
+          for (auto cx = pos.x; cx < pos.x + static_cast<std::ptrdiff_t>(area.x); ++cx) {
+            if (cx < 0 || cy < 0) {continue;}
+            cells(Pos{static_cast<std::size_t>(cx), static_cast<std::size_t>(cy)}, cell);
+          }
+        }
+      }
+      if (!same(fill, cells)) {++failures;}
+    }
+    TEST_CHECK(failures == 0);
+
+    // cells that were never drawn leave what is underneath alone
+    Buffer buf {size, blank};
+    buf.fill_rect(Point{-2, -2}, Size{40, 40}, Cell{1, Style{}, "x"});
+    TEST_CHECK(same(buf, Buffer{size, blank}));
+  }
+
+  {
+    // text segmented once draws the same cells as the string it came from
+    std::array<std::string_view, 7> const strs {
+      "FLOATYBOX v0.1.0",
+      " ",
+      "",
+      "wide 界面 text",
+      "e\u0301 combining",
+      "flag \U0001F1EF\U0001F1F5 and \U0001F468\u200D\U0001F469",
+      "▁▂▃▄▅▆▇█",
+    };
+    auto const faded = Style{Style::Bit_24, Style::Null, RGBA::hex("61afef80"), RGBA::hex("1b1e2480")};
+    for (auto const str : strs) {
+      Prepared_text const text {str};
+      TEST_CHECK(text.str() == str);
+      std::size_t cols {0};
+      for (auto const& glyph : text.glyphs()) {cols += glyph.cols();}
+      TEST_CHECK(text.cols() == cols);
+
+      for (auto const& style : {ink, faded}) {
+        Buffer lhs {Size{30, 3}, blank};
+        Buffer rhs {Size{30, 3}, blank};
+        lhs.put(Pos{1, 0}, "underneath ###", ink);
+        rhs.put(Pos{1, 0}, "underneath ###", ink);
+        lhs.put(Pos{2, 0}, str, style, 2);
+        rhs.put(Pos{2, 0}, text, style, 2);
+        TEST_CHECK(same(lhs, rhs));
+        TEST_CHECK(lhs.cursor() == rhs.cursor());
+      }
+    }
+  }
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
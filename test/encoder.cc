@@ -0,0 +1,320 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "app/window.hh"
+
+#include "ob/term.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <array>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace aec = OB::Term::ANSI_Escape_Codes;
+
+using RGBA = OB::Prism::RGBA;
+
+// golden output, the bytes the encoder writes against the aec strings the
+// old writer appended one after another
+
+// join sgr sequences into the single sequence the encoder writes,
+// "\x1b[0m\x1b[1m" becomes "\x1b[0;1m"
+static std::string join(std::vector<std::string> const& seqs) {
+  std::string params;
+  for (auto const& seq : seqs) {
+    if (!params.empty()) {params += ';';}
+    params += seq.substr(2, seq.size() - 3);
+  }
+  return params.empty() ? params : aec::esc + "[" + params + "m";
+}
+
+static std::string hex(RGBA const& rgba) {
+  char str[7] {};
+  std::snprintf(str, sizeof(str), "%02x%02x%02x", rgba.r(), rgba.g(), rgba.b());
+  return str;
+}
+
+// the attribute sequences in the order the old writer sent them
+static std::vector<std::string> attrs(std::uint8_t const attr) {
+  std::vector<std::string> seqs;
+  if (attr & Style::Bold) {seqs.emplace_back(aec::bold);}
+  if (attr & Style::Reverse) {seqs.emplace_back(aec::reverse);}
+  if (attr & Style::Underline) {seqs.emplace_back(aec::underline);}
+  return seqs;
+}
+
+static std::vector<std::string> operator+(std::vector<std::string> lhs, std::vector<std::string> const& rhs) {
+  lhs.insert(lhs.end(), rhs.begin(), rhs.end());
+  return lhs;
+}
+
+// bytes written by sgr from the unknown start state
+static std::string sgr(Style const& next, std::uint8_t const depth = Style::Bit_24) {
+  Encoder enc;
+  enc.depth = depth;
+  enc.sgr(next);
+  return enc.line;
+}
+
+// bytes written by sgr from the state prev left
+static std::string sgr(Style const& prev, Style const& next, std::uint8_t const depth = Style::Bit_24) {
+  Encoder enc;
+  enc.depth = depth;
+  enc.sgr(prev);
+  enc.line.clear();
+  enc.sgr(next);
+  return enc.line;
+}
+
+static bool same(std::string const& actual, std::string const& expected) {
+  if (actual == expected) {return true;}
+  auto const show = [](std::string str) {
+    for (std::size_t i = 0; (i = str.find('\x1b', i)) != std::string::npos;) {
+      str.replace(i, 1, "\\e");
+    }
+    return str;
+  };
+  std::cerr << "got '" << show(actual) << "' expected '" << show(expected) << "'\n";
+  return false;
+}
+
+static void test_sgr() {
+  // channels of one, two and three digits, both ends of the decimal table
+  std::array<std::uint8_t, 8> const values {0, 9, 10, 99, 100, 199, 200, 255};
+  RGBA const base {27, 30, 36, 255};
+
+  // the attributes cycle through every combination across the colours
+  std::uint8_t attr {0};
+  for (auto const r : values) {
+    for (auto const g : values) {
+      for (auto const b : values) {
+        attr = static_cast<std::uint8_t>((attr + 1) % 8);
+        RGBA const col {r, g, b, std::uint8_t{255}};
+        Style const fg {Style::Bit_24, attr, col, base};
+        Style const bg {Style::Bit_24, attr, base, col};
+
+        // from the unknown start state everything follows a reset
+        TEST_CHECK(same(sgr(fg), join(std::vector<std::string>{aec::clear} + attrs(attr) + std::vector<std::string>{aec::fg_true(hex(col)), aec::bg_true(hex(base))})));
+        TEST_CHECK(same(sgr(bg), join(std::vector<std::string>{aec::clear} + attrs(attr) + std::vector<std::string>{aec::fg_true(hex(base)), aec::bg_true(hex(col))})));
+
+        // only the colour that changed is sent
+        Style const prev {Style::Bit_24, attr, base, base};
+        TEST_CHECK(same(sgr(prev, fg), col == base ? "" : aec::fg_true(hex(col))));
+        TEST_CHECK(same(sgr(prev, bg), col == base ? "" : aec::bg_true(hex(col))));
+      }
+    }
+  }
+
+  RGBA const fg {224, 108, 117, 255};
+  RGBA const bg {40, 44, 52, 255};
+  for (std::uint8_t from = 0; from < 8; ++from) {
+    for (std::uint8_t to = 0; to < 8; ++to) {
+      Style const prev {Style::Bit_24, from, fg, bg};
+      Style const next {Style::Bit_24, to, fg, bg};
+      if (from & ~to) {
+        // dropping an attribute resets and sends the rest again
+        TEST_CHECK(same(sgr(prev, next), join(std::vector<std::string>{aec::clear} + attrs(to) + std::vector<std::string>{aec::fg_true(hex(fg)), aec::bg_true(hex(bg))})));
+      }
+      else {
+        // added attributes only
+        TEST_CHECK(same(sgr(prev, next), join(attrs(static_cast<std::uint8_t>(to & ~from)))));
+      }
+    }
+
+    // back to the terminal default, or to an unknown style
+    Style const prev {Style::Bit_24, from, fg, bg};
+    TEST_CHECK(same(sgr(prev, Style{Style::Default, Style::Null, {}, {}}), aec::clear));
+    TEST_CHECK(same(sgr(prev, Style{Style::Default, from, {}, {}}), join(std::vector<std::string>{aec::clear} + attrs(from))));
+    TEST_CHECK(same(sgr(prev, Style{}), aec::clear));
+  }
+
+  // the default style leaves the colours to the terminal
+  for (std::uint8_t val = 0; val < 8; ++val) {
+    TEST_CHECK(same(sgr(Style{Style::Default, val, fg, bg}), join(std::vector<std::string>{aec::clear} + attrs(val))));
+  }
+
+  // colours of the 256 colour cube map to their own index
+  struct Cube {
+    RGBA rgba;
+    std::size_t index;
+  };
+  std::array<Cube, 4> const cube {{
+    {RGBA{0, 0, 0, 255}, 16},
+    {RGBA{95, 135, 175, 255}, 67},
+    {RGBA{215, 0, 95, 255}, 161},
+    {RGBA{255, 255, 255, 255}, 231},
+  }};
+  for (auto const& lhs : cube) {
+    for (auto const& rhs : cube) {
+      Style const style {Style::Bit_24, Style::Bold, lhs.rgba, rhs.rgba};
+      TEST_CHECK(same(sgr(style, Style::Bit_8), join({aec::clear, aec::bold, aec::fg_256(std::to_string(lhs.index)), aec::bg_256(std::to_string(rhs.index))})));
+    }
+  }
+}
+
+static void test_cursor() {
+  std::vector<Cell> cells(400);
+
+  // without a known position the cursor is set absolutely, past the table too
+  for (auto const y : {0ul, 8ul, 9ul, 254ul, 255ul, 300ul}) {
+    for (auto const x : {0ul, 9ul, 99ul, 255ul, 399ul}) {
+      Encoder enc;
+      enc.cursor_move(cells.data(), Pos{x, y});
+      TEST_CHECK(same(enc.line, aec::cursor_set(x + 1, y + 1)));
+      TEST_CHECK(enc.cursor_valid && enc.cursor.x == x && enc.cursor.y == y);
+    }
+  }
+
+  // relative moves from a known position, the cells in between are in another
+  // style so they can not be reprinted
+  Style const style {Style::Bit_24, Style::Null, RGBA{255, 255, 255, 255}, RGBA{0, 0, 0, 255}};
+  struct Move {
+    Pos from;
+    Pos to;
+    std::string expected;
+  };
+  std::vector<Move> const moves {
+    {Pos{10, 5}, Pos{10, 5}, ""},
+    // a count of one is the default parameter and left out
+    {Pos{10, 5}, Pos{11, 5}, aec::esc + "[C"},
+    {Pos{10, 5}, Pos{15, 5}, aec::cursor_right(5)},
+    {Pos{10, 5}, Pos{9, 5}, aec::esc + "[D"},
+    {Pos{10, 5}, Pos{7, 5}, aec::cursor_left(3)},
+    {Pos{10, 5}, Pos{0, 5}, aec::cr},
+    {Pos{150, 5}, Pos{3, 5}, aec::cr + aec::cursor_right(3)},
+    {Pos{10, 5}, Pos{0, 6}, aec::crnl},
+    {Pos{10, 5}, Pos{10, 6}, aec::cursor_set(11, 7)},
+    {Pos{10, 5}, Pos{300, 5}, aec::cursor_right(290)},
+  };
+  for (auto const& move : moves) {
+    Encoder enc;
+    enc.sgr(style);
+    enc.line.clear();
+    enc.cursor = move.from;
+    enc.cursor_valid = true;
+    enc.cursor_move(cells.data(), move.to);
+    TEST_CHECK(same(enc.line, move.expected));
+  }
+
+  // cells in the current style are cheaper to print again than to skip
+  for (auto& cell : cells) {
+    cell = Cell{1, style, "a"};
+  }
+  Encoder enc;
+  enc.sgr(style);
+  enc.line.clear();
+  enc.cursor = Pos{10, 5};
+  enc.cursor_valid = true;
+  enc.cursor_move(cells.data(), Pos{13, 5});
+  TEST_CHECK(same(enc.line, "aaa"));
+}
+
+static void test_diff() {
+  // one field of one cell changed, on every column of rows of many widths, so
+  // each column falls to the wide kernel, the pair kernel and the scalar tail
+  Style const base {Style::Bit_24, Style::Null, RGBA::hex("1b1e24"), RGBA::hex("1b1e24")};
+  std::vector<Style> styles {
+    Style{Style::Bit_24, Style::Bold, base.fg, base.bg},
+    Style{Style::Default, Style::Null, base.fg, base.bg},
+    Style{Style::Bit_24, Style::Null, RGBA::hex("df6c3e"), base.bg},
+    Style{Style::Bit_24, Style::Null, base.fg, RGBA::hex("df6c3e")},
+  };
+  Cell const blank {0, base, " "};
+  for (std::size_t width = 1; width <= 37; ++width) {
+    Buffer const prev {Size{width, 3}, blank};
+    for (std::size_t x = 0; x < width; ++x) {
+      std::vector<Cell> changes {Cell{0, base, "b"}};
+      for (auto const& style : styles) {changes.emplace_back(Cell{0, style, " "});}
+      for (auto const& change : changes) {
+        Buffer cur {prev};
+        cur.at(Pos{x, 1}) = change;
+        Encoder enc;
+        enc.rows(cur, prev, 0, 3, true);
+        Encoder expected;
+        expected.cursor_move(cur.data() + cur.stride(), Pos{x, 1});
+        expected.sgr(change.style);
+        expected.line += change.text.str();
+        TEST_CHECK(same(enc.line, expected.line));
+      }
+
+      // the zidx is not drawn
+      Buffer cur {prev};
+      cur.at(Pos{x, 1}).zidx = 5;
+      Encoder enc;
+      enc.rows(cur, prev, 0, 3, true);
+      TEST_CHECK(same(enc.line, ""));
+    }
+  }
+
+  // below 24 bit a colour that quantizes to the same index is no change
+  Buffer const prev {Size{9, 1}, blank};
+  Buffer near {prev};
+  near.at(Pos{4, 0}).style.fg = RGBA::hex("1d1f25");
+  Buffer far {prev};
+  far.at(Pos{4, 0}).style.fg = RGBA::hex("df6c3e");
+  for (auto const depth : {Style::Bit_8, Style::Bit_4}) {
+    Encoder enc;
+    enc.depth = depth;
+    enc.rows(near, prev, 0, 1, true);
+    TEST_CHECK(same(enc.line, ""));
+    enc.rows(far, prev, 0, 1, true);
+    TEST_CHECK(!enc.line.empty());
+  }
+}
+
+int main() {
+  test_sgr();
+  test_cursor();
+  test_diff();
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "info.hh"
+#include "app/app.hh"
+#include "app/window.hh"
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+// the headless driver renders a set number of frames at a fixed size to a
+// file or only to memory, then prints its stats
+
+static std::string read(std::string const& path) {
+  std::ifstream file {path, std::ios::binary};
+  std::ostringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+
+// the value of a stats line, "bytes 1234" for name "bytes"
+static std::string stat(std::string const& stats, std::string const& name) {
+  std::istringstream ss {stats};
+  for (std::string line; std::getline(ss, line);) {
+    if (line.compare(0, name.size() + 1, name + " ") == 0) {
+      return line.substr(name.size() + 1);
+    }
+  }
+  return {};
+}
+
+struct App_test {
+  // the stats printed, with the last frame rendered left in frame, throws
+  // what the driver throws
+  static std::string run(std::string const& args, Buffer* frame = nullptr) {
+    std::vector<std::string> words {"floatybox"};
+    std::istringstream ss {args};
+    for (std::string word; ss >> word;) {words.emplace_back(word);}
+    std::vector<char*> argv;
+    for (auto& word : words) {argv.emplace_back(word.data());}
+    OB::Parg pg {static_cast<int>(argv.size()), argv.data()};
+    if (program_info(pg) != 0) {throw std::runtime_error("invalid arguments");}
+
+    App app {pg};
+    std::ostringstream out;
+    auto const buf = std::cout.rdbuf(out.rdbuf());
+    try {
+      app.run();
+    }
+    catch (...) {
+      std::cout.rdbuf(buf);
+      throw;
+    }
+    std::cout.rdbuf(buf);
+    if (frame) {
+      *frame = app._win.buf_prev;
+    }
+    return out.str();
+  }
+};
+
+static bool throws(std::string const& args) {
+  try {
+    App_test::run(args);
+  }
+  catch (std::runtime_error const&) {
+    return true;
+  }
+  return false;
+}
+
+int main() {
+  {
+    // text frames are the rows of cells, one line per row
+    Buffer frame;
+    auto const stats = App_test::run("--headless --seed=7 --frames=30 --size=40x20 --format=text --output=headless.txt", &frame);
+    TEST_CHECK(stat(stats, "frames") == "30");
+    TEST_CHECK(stat(stats, "size") == "40x20");
+    auto const text = read("headless.txt");
+    TEST_CHECK(stat(stats, "bytes") == std::to_string(text.size()));
+
+    std::vector<std::string> lines;
+    std::istringstream ss {text};
+    for (std::string line; std::getline(ss, line);) {lines.emplace_back(line);}
+    TEST_CHECK(lines.size() == 30 * 20);
+
+    // the last frame in the file is the last frame rendered
+    TEST_CHECK(frame.size() == Size(40, 20));
+    if (lines.size() == 30 * 20) {
+      for (std::size_t y = 0; y < 20; ++y) {
+        std::string row;
+        auto const* cells = frame.data() + y * frame.stride();
+        for (std::size_t x = 0; x < 40; ++x) {row += cells[x].text.str();}
+        TEST_CHECK(lines[29 * 20 + y] == row);
+      }
+    }
+  }
+
+  {
+    // a seed gives the same frames every run, in memory nothing is written
+    auto const ansi = App_test::run("--headless --seed=3 --frames=60 --format=ansi --output=headless.ansi");
+    auto const first = read("headless.ansi");
+    App_test::run("--headless --seed=3 --frames=60 --format=ansi --output=headless.ansi");
+    TEST_CHECK(!first.empty() && read("headless.ansi") == first);
+    TEST_CHECK(stat(ansi, "bytes") == std::to_string(first.size()));
+    TEST_CHECK(stat(ansi, "size") == "80x24");
+
+    auto const memory = App_test::run("--headless --seed=3 --frames=60");
+    TEST_CHECK(stat(memory, "frames") == "60");
+    TEST_CHECK(stat(memory, "bytes") == "0");
+  }
+
+  // sizes below the playfield and unknown formats are refused
+  TEST_CHECK(throws("--headless --size=11x17"));
+  TEST_CHECK(throws("--headless --size=12x16"));
+  TEST_CHECK(throws("--headless --size=80"));
+  TEST_CHECK(throws("--headless --size=axb"));
+  TEST_CHECK(throws("--headless --format=html"));
+  TEST_CHECK(!throws("--headless --size=12x17 --frames=5"));
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
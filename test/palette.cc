@@ -0,0 +1,109 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "info.hh"
+#include "app/app.hh"
+#include "app/window.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <vector>
+#include <iostream>
+
+using RGBA = OB::Prism::RGBA;
+
+// the theme resolved once into rgba, the trail ramp has to give the colours
+// compositing the faded trail over the bg gives
+struct App_test {
+  static void palette(OB::Parg& pg) {
+    App app {pg};
+    app._headless = true;
+    app._width = 80;
+    app._height = 24;
+    app._fixed_size = true;
+    app.window_init();
+
+    auto const& theme = app._cfg.style;
+    auto const& palette = app._palette;
+    TEST_CHECK(palette.box == RGBA(theme.box));
+    TEST_CHECK(palette.goal == RGBA(theme.goal));
+    TEST_CHECK(palette.goal_pass == RGBA(theme.goal_pass));
+    TEST_CHECK(palette.goal_miss == RGBA(theme.goal_miss));
+
+    RGBA const trail {theme.trail};
+    TEST_CHECK(palette.trail.front() == theme.bg);
+    TEST_CHECK(palette.trail.back() == trail);
+
+    Style const base {Style::Bit_24, Style::Null, theme.bg, theme.bg};
+    std::size_t failures {0};
+    for (std::size_t alpha = 0; alpha < palette.trail.size(); ++alpha) {
+      Buffer world {Size{1, 1}, Cell{0, base, " "}};
+      Buffer layer {Size{1, 1}};
+      RGBA const faded {trail.r(), trail.g(), trail.b(), static_cast<std::uint8_t>(alpha)};
+      layer(Pos{0, 0}, Cell{1, Style{Style::Bit_24, Style::Null, faded, theme.bg}, "█"});
+      world.compose(layer);
+      if (world.at(Pos{0, 0}).style.fg != palette.trail[alpha]) {
+        if (failures++ == 0) {
+          std::cerr << "alpha " << alpha << " composites to " << world.at(Pos{0, 0}).style.fg << ", the ramp has " << palette.trail[alpha] << "\n";
+        }
+      }
+    }
+    TEST_CHECK(failures == 0);
+  }
+};
+
+int main() {
+  std::vector<char const*> args {"floatybox", "--headless"};
+  OB::Parg pg {static_cast<int>(args.size()), const_cast<char**>(args.data())};
+  if (program_info(pg) != 0) {return EXIT_FAILURE;}
+
+  App_test::palette(pg);
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,407 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "info.hh"
+#include "app/app.hh"
+#include "app/window.hh"
+#include "ob/text.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// the optimised stream has to leave a terminal showing the frame that was
+// rendered, run the headless driver for the ansi stream, replay it and
+// compare the text and colours of every cell with the last frame rendered
+
+// the graphic rendition a terminal holds, colours as they were sent
+struct Sgr {
+  enum Kind : std::uint8_t {Default, Indexed, Rgb};
+  struct Colour {
+    Kind kind {Default};
+    std::uint32_t value {0};
+    bool operator==(Colour const& rhs) const {return kind == rhs.kind && value == rhs.value;}
+  };
+  bool bold {false};
+  bool underline {false};
+  bool reverse {false};
+  Colour fg;
+  Colour bg;
+
+  // the colour behind the text, which is all a blank cell shows
+  Colour back() const {return reverse ? fg : bg;}
+  bool operator==(Sgr const& rhs) const {
+    return bold == rhs.bold && underline == rhs.underline && reverse == rhs.reverse && fg == rhs.fg && bg == rhs.bg;
+  }
+};
+
+static std::ostream& operator<<(std::ostream& os, Sgr::Colour const& obj) {
+  if (obj.kind == Sgr::Default) {return os << "default";}
+  if (obj.kind == Sgr::Indexed) {return os << "index " << obj.value;}
+  return os << "rgb " << ((obj.value >> 16) & 0xff) << "," << ((obj.value >> 8) & 0xff) << "," << (obj.value & 0xff);
+}
+
+static std::ostream& operator<<(std::ostream& os, Sgr const& obj) {
+  return os << "fg " << obj.fg << " bg " << obj.bg << (obj.bold ? " bold" : "") << (obj.underline ? " underline" : "") << (obj.reverse ? " reverse" : "");
+}
+
+// a terminal model for the sequences the encoder writes
+class Screen {
+public:
+  struct Cell {
+    std::string text {" "};
+    Sgr sgr;
+  };
+
+  Screen(std::size_t const width, std::size_t const height) :
+    _width {width},
+    _height {height},
+    _cells(width * height) {
+  }
+
+  void feed(std::string_view const data) {
+    std::size_t i {0};
+    while (i < data.size()) {
+      auto const c = data[i];
+      if (c == '\x1b') {
+        i = csi(data, i);
+        continue;
+      }
+      if (c == '\r') {
+        _x = 0;
+        _pending = false;
+        ++i;
+        continue;
+      }
+      if (c == '\n') {
+        if (_y + 1 < _height) {++_y;}
+        _pending = false;
+        ++i;
+        continue;
+      }
+      // a run of printable text
+      auto end = i;
+      while (end < data.size() && data[end] != '\x1b' && static_cast<unsigned char>(data[end]) >= 0x20) {++end;}
+      if (end == i) {
+        ++i;
+        continue;
+      }
+      OB::Text::View view {data.substr(i, end - i)};
+      for (auto const& e : view) {
+        put(e.str, e.cols);
+      }
+      i = end;
+    }
+  }
+
+  Cell const& at(std::size_t const x, std::size_t const y) const {
+    return _cells[y * _width + x];
+  }
+
+  Sgr const& sgr() const {
+    return _sgr;
+  }
+
+private:
+  void put(std::string_view const str, std::size_t const cols) {
+    // the wrap is only taken when the next character arrives
+    if (_pending) {
+      _pending = false;
+      _x = 0;
+      if (_y + 1 < _height) {++_y;}
+    }
+    _cells[_y * _width + _x] = Cell{std::string(str), _sgr};
+    if (cols == 2 && _x + 1 < _width) {
+      _cells[_y * _width + _x + 1] = Cell{"", _sgr};
+    }
+    if (_x + cols >= _width) {
+      _pending = true;
+    }
+    else {
+      _x += cols;
+    }
+  }
+
+  // erased cells take the current background, as with back colour erase
+  Cell blank() const {
+    Cell cell;
+    cell.sgr.bg = _sgr.bg;
+    return cell;
+  }
+
+  void rendition(std::vector<std::size_t> const& params) {
+    auto const colour = [&](std::size_t& n, Sgr::Colour& val) {
+      if (n + 2 < params.size() && params[n + 1] == 5) {
+        val = {Sgr::Indexed, static_cast<std::uint32_t>(params[n + 2])};
+        n += 2;
+      }
+      else if (n + 4 < params.size() && params[n + 1] == 2) {
+        val = {Sgr::Rgb, static_cast<std::uint32_t>((params[n + 2] << 16) | (params[n + 3] << 8) | params[n + 4])};
+        n += 4;
+      }
+      else {
+        std::cerr << "malformed colour sequence\n";
+        ++test_failures;
+        n = params.size();
+      }
+    };
+    for (std::size_t n = 0; n < params.size(); ++n) {
+      auto const val = params[n];
+      if (val == 0) {_sgr = Sgr{};}
+      else if (val == 1) {_sgr.bold = true;}
+      else if (val == 4) {_sgr.underline = true;}
+      else if (val == 7) {_sgr.reverse = true;}
+      else if (val == 22) {_sgr.bold = false;}
+      else if (val == 24) {_sgr.underline = false;}
+      else if (val == 27) {_sgr.reverse = false;}
+      else if (val >= 30 && val <= 37) {_sgr.fg = {Sgr::Indexed, static_cast<std::uint32_t>(val - 30)};}
+      else if (val >= 90 && val <= 97) {_sgr.fg = {Sgr::Indexed, static_cast<std::uint32_t>(val - 90 + 8)};}
+      else if (val >= 40 && val <= 47) {_sgr.bg = {Sgr::Indexed, static_cast<std::uint32_t>(val - 40)};}
+      else if (val >= 100 && val <= 107) {_sgr.bg = {Sgr::Indexed, static_cast<std::uint32_t>(val - 100 + 8)};}
+      else if (val == 38) {colour(n, _sgr.fg);}
+      else if (val == 48) {colour(n, _sgr.bg);}
+      else if (val == 39) {_sgr.fg = {};}
+      else if (val == 49) {_sgr.bg = {};}
+      else {
+        std::cerr << "unexpected rendition " << val << "\n";
+        ++test_failures;
+      }
+    }
+  }
+
+  // parse the escape sequence at i, return the index after it
+  std::size_t csi(std::string_view const data, std::size_t i) {
+    if (i + 1 >= data.size() || data[i + 1] != '[') {return i + 2;}
+    i += 2;
+    bool priv {false};
+    if (i < data.size() && data[i] == '?') {
+      priv = true;
+      ++i;
+    }
+    std::vector<std::size_t> params {0};
+    for (; i < data.size() && ((data[i] >= '0' && data[i] <= '9') || data[i] == ';'); ++i) {
+      if (data[i] == ';') {
+        params.emplace_back(0);
+      }
+      else {
+        params.back() = params.back() * 10 + static_cast<std::size_t>(data[i] - '0');
+      }
+    }
+    if (i >= data.size()) {return i;}
+    auto const fn = data[i++];
+    // modes such as synchronized output do not move anything
+    if (priv) {return i;}
+    if (fn == 'm') {
+      rendition(params);
+      return i;
+    }
+
+    auto const param = [&](std::size_t const n) {
+      return n < params.size() && params[n] ? params[n] : 1;
+    };
+    _pending = false;
+    switch (fn) {
+      case 'H': {
+        _y = std::min(param(0), _height) - 1;
+        _x = std::min(param(1), _width) - 1;
+        break;
+      }
+      case 'C': {
+        _x = std::min(_x + param(0), _width - 1);
+        break;
+      }
+      case 'D': {
+        _x = _x > param(0) ? _x - param(0) : 0;
+        break;
+      }
+      case 'J': {
+        if (params[0] == 2) {
+          std::fill(_cells.begin(), _cells.end(), blank());
+        }
+        break;
+      }
+      case 'P': {
+        // the rest of the row moves left, blanks come in at the end
+        auto const row = _cells.begin() + static_cast<std::ptrdiff_t>(_y * _width);
+        auto const n = std::min(param(0), _width - _x);
+        std::move(row + static_cast<std::ptrdiff_t>(_x + n), row + static_cast<std::ptrdiff_t>(_width), row + static_cast<std::ptrdiff_t>(_x));
+        std::fill(row + static_cast<std::ptrdiff_t>(_width - n), row + static_cast<std::ptrdiff_t>(_width), blank());
+        break;
+      }
+      default: {
+        std::cerr << "unexpected sequence '" << fn << "'\n";
+        ++test_failures;
+        break;
+      }
+    }
+    return i;
+  }
+
+  std::size_t _width {0};
+  std::size_t _height {0};
+  std::vector<Cell> _cells;
+  std::size_t _x {0};
+  std::size_t _y {0};
+  bool _pending {false};
+  Sgr _sgr;
+}; // class Screen
+
+static std::string read(std::string const& path) {
+  std::ifstream file {path, std::ios::binary};
+  std::ostringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+
+// the rendition a style is drawn with, a fresh encoder writes it from a
+// reset and the screen model reads it back
+static Sgr expected(Style const& style, Style::Type const depth) {
+  Encoder enc;
+  enc.depth = depth;
+  enc.sgr(style, true);
+  Screen screen {1, 1};
+  screen.feed(enc.line);
+  return screen.sgr();
+}
+
+// runs the headless driver in process, which leaves the last frame rendered
+// in the window to compare against
+struct App_test {
+  // the number of cells that differ, reported on stderr
+  static std::size_t replay(std::string const& args) {
+    std::vector<std::string> words {"floatybox"};
+    std::istringstream ss {args};
+    for (std::string word; ss >> word;) {words.emplace_back(word);}
+    std::vector<char*> argv;
+    for (auto& word : words) {argv.emplace_back(word.data());}
+    OB::Parg pg {static_cast<int>(argv.size()), argv.data()};
+    if (program_info(pg) != 0) {
+      std::cerr << "invalid arguments: " << args << "\n";
+      return 1;
+    }
+
+    App app {pg};
+    {
+      // the driver prints its stats, keep them out of the test log
+      std::ostringstream out;
+      auto const buf = std::cout.rdbuf(out.rdbuf());
+      app.run();
+      std::cout.rdbuf(buf);
+    }
+
+    auto const& frame = app._win.buf_prev;
+    auto const depth = static_cast<Style::Type>(app._win.depth.load());
+    auto const width = frame.size().x;
+    auto const height = frame.size().y;
+    Screen screen {width, height};
+    screen.feed(read("replay.ansi"));
+
+    std::size_t failures {0};
+    for (std::size_t y = 0; y < height; ++y) {
+      auto const* cells = frame.data() + y * frame.stride();
+      for (std::size_t x = 0; x < width; ++x) {
+        auto const& cell = cells[x];
+        auto const& shown = screen.at(x, y);
+        auto const text = std::string(cell.text.str());
+        auto const sgr = expected(cell.style, depth);
+        // a blank shows only its background, the rest of a wide glyph
+        // nothing of its own
+        bool const same = shown.text == text && (text.empty() ||
+          (text == " " && !sgr.underline ? shown.sgr.back() == sgr.back() : shown.sgr == sgr));
+        if (same) {continue;}
+        if (failures++ == 0) {
+          std::cerr << args << ": cell " << x << "," << y << " shows '" << shown.text << "' " << shown.sgr << ", rendered '" << text << "' " << sgr << "\n";
+        }
+      }
+    }
+    return failures;
+  }
+};
+
+int main() {
+  struct Size {
+    std::size_t width;
+    std::size_t height;
+  };
+  std::vector<Size> const sizes {{80, 24}, {12, 17}, {133, 41}};
+  std::vector<std::size_t> const frames {1, 2, 90, 300};
+  // every option that changes the stream, the screen must stay the same
+  std::vector<std::string> const modes {
+    "",
+    "--scroll",
+    "--diff-full",
+    "--sync",
+    "--threads=4",
+    "--threads=1",
+    "--colour=off",
+    "--colour-depth=8",
+    "--colour-depth=4 --scroll",
+  };
+
+  for (auto const& size : sizes) {
+    for (auto const n : frames) {
+      auto const args = "--headless --seed=7 --frames=" + std::to_string(n) + " --size=" + std::to_string(size.width) + "x" + std::to_string(size.height);
+      for (auto const& mode : modes) {
+        auto const failures = App_test::replay(args + " " + mode + " --format=ansi --output=replay.ansi");
+        if (failures) {
+          std::cerr << size.width << "x" << size.height << " " << n << " frames " << mode << ": " << failures << " cells differ from the rendered frame\n";
+          ++test_failures;
+        }
+      }
+    }
+  }
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "ob/triple.hh"
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <atomic>
+#include <thread>
+#include <iostream>
+
+int main() {
+  {
+    // one thread, the newest value published is the one taken
+    OB::Triple<int> queue;
+    TEST_CHECK(!queue.pending());
+    TEST_CHECK(!queue.acquire());
+
+    queue.back() = 1;
+    TEST_CHECK(queue.publish());
+    TEST_CHECK(queue.pending());
+    queue.back() = 2;
+    // 1 was never taken, 2 replaces it
+    TEST_CHECK(!queue.publish());
+    TEST_CHECK(queue.acquire());
+    TEST_CHECK(queue.front() == 2);
+    TEST_CHECK(!queue.pending());
+    TEST_CHECK(!queue.acquire());
+    TEST_CHECK(queue.front() == 2);
+
+    queue.back() = 3;
+    TEST_CHECK(queue.publish());
+    TEST_CHECK(queue.acquire());
+    TEST_CHECK(queue.front() == 3);
+  }
+
+  {
+    // a producer and a consumer, the consumer sees values in order and always
+    // ends on the last
+    constexpr std::size_t count {200000};
+    OB::Triple<std::size_t> queue;
+    std::atomic<bool> done {false};
+    std::size_t order {0};
+    std::size_t last {0};
+    std::thread consumer {[&]() {
+      for (;;) {
+        auto const finished = done.load();
+        if (queue.acquire()) {
+          if (queue.front() <= last) {++order;}
+          last = queue.front();
+        }
+        else if (finished) {
+          break;
+        }
+      }
+    }};
+    for (std::size_t i = 1; i <= count; ++i) {
+      queue.back() = i;
+      queue.publish();
+    }
+    done = true;
+    consumer.join();
+    TEST_CHECK(order == 0);
+    TEST_CHECK(last == count);
+  }
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
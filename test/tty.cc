@@ -0,0 +1,134 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+
+#include <cstdlib>
+
+#include <chrono>
+#include <string>
+#include <iostream>
+
+// the program on a pseudo terminal, quit after the first frames, the terminal
+// must be left as it was found, blocking, since the shell shares its flags
+
+// read and drop what the program wrote for up to ms
+static void read_for(int const fd, int const ms) {
+  auto const end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+  char buf[4096];
+  while (std::chrono::steady_clock::now() < end) {
+    pollfd pfd {fd, POLLIN, 0};
+    if (::poll(&pfd, 1, 20) > 0) {
+      if (::read(fd, buf, sizeof(buf)) <= 0) {return;}
+    }
+  }
+}
+
+static bool nonblocking(int const fd) {
+  return ::fcntl(fd, F_GETFL) & O_NONBLOCK;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "usage: test_tty <floatybox>\n";
+    return EXIT_FAILURE;
+  }
+
+  auto const master = ::posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || ::grantpt(master) < 0 || ::unlockpt(master) < 0) {
+    // nothing to test against without a pseudo terminal
+    std::cerr << "no pseudo terminal, skipped\n";
+    return EXIT_SUCCESS;
+  }
+  std::string const name {::ptsname(master)};
+  auto const slave = ::open(name.c_str(), O_RDWR | O_NOCTTY);
+  TEST_CHECK(slave >= 0);
+  winsize const size {30, 100, 0, 0};
+  ::ioctl(slave, TIOCSWINSZ, &size);
+  TEST_CHECK(!nonblocking(slave));
+
+  auto const pid = ::fork();
+  if (pid == 0) {
+    // the slave becomes the controlling terminal and the standard streams
+    ::setsid();
+    ::ioctl(slave, TIOCSCTTY, 0);
+    ::dup2(slave, STDIN_FILENO);
+    ::dup2(slave, STDOUT_FILENO);
+    ::dup2(slave, STDERR_FILENO);
+    ::setenv("TERM", "xterm-256color", 1);
+    ::execl(argv[1], argv[1], static_cast<char*>(nullptr));
+    ::_exit(127);
+  }
+
+  read_for(master, 1000);
+  TEST_CHECK(::write(master, "q", 1) == 1);
+
+  int status {0};
+  auto const end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (::waitpid(pid, &status, WNOHANG) == 0) {
+    if (std::chrono::steady_clock::now() > end) {
+      ::kill(pid, SIGKILL);
+      ::waitpid(pid, &status, 0);
+      std::cerr << "the program did not quit\n";
+      ++test_failures;
+      break;
+    }
+    read_for(master, 20);
+  }
+  TEST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  // the open file description outlives the program
+  TEST_CHECK(!nonblocking(slave));
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
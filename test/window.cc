@@ -0,0 +1,270 @@
+/*
+                                    88888888
+                                  888888888888
+                                 88888888888888
+                                8888888888888888
+                               888888888888888888
+                              888888  8888  888888
+                              88888    88    88888
+                              888888  8888  888888
+                              88888888888888888888
+                              88888888888888888888
+                             8888888888888888888888
+                          8888888888888888888888888888
+                        88888888888888888888888888888888
+                              88888888888888888888
+                            888888888888888888888888
+                           888888  8888888888  888888
+                           888     8888  8888     888
+                                   888    888
+
+                                   OCTOBANANA
+
+Licensed under the MIT License
+
+Copyright (c) 2020 Brett Robinson <https://octobanana.com/>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "test.hh"
+
+#include "app/window.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+
+using RGBA = OB::Prism::RGBA;
+
+static bool same(Cell const& lhs, Cell const& rhs) {
+  return lhs.zidx == rhs.zidx && lhs.text == rhs.text &&
+    lhs.style.type == rhs.style.type && lhs.style.attr == rhs.style.attr &&
+    lhs.style.fg.value() == rhs.style.fg.value() && lhs.style.bg.value() == rhs.style.bg.value();
+}
+
+// every cell of buf is cell
+static bool filled(Buffer const& buf, Cell const& cell) {
+  for (std::size_t y = 0; y < buf.size().y; ++y) {
+    for (std::size_t x = 0; x < buf.size().x; ++x) {
+      if (!same(buf.at(Pos{x, y}), cell)) {return false;}
+    }
+  }
+  return true;
+}
+
+// bytes waiting in the pipe
+static std::string pending(int const fd) {
+  std::string str;
+  char buf[4096];
+  for (;;) {
+    auto const num = ::read(fd, buf, sizeof(buf));
+    if (num <= 0) {break;}
+    str.append(buf, static_cast<std::size_t>(num));
+  }
+  return str;
+}
+
+static bool starts(std::string const& str, std::string const& prefix) {
+  return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+}
+
+static bool ends(std::string const& str, std::string const& suffix) {
+  return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main() {
+  auto const base = Style{Style::Bit_24, Style::Null, RGBA::hex("1b1e24"), RGBA::hex("1b1e24")};
+  auto const ink = Style{Style::Bit_24, Style::Null, RGBA::hex("df6c3e"), RGBA::hex("1b1e24")};
+  Cell const blank {0, base, " "};
+
+  {
+    // the frame just rendered is kept by swapping the buffers, not copying
+    // them, and the next frame starts from the base cell
+    std::ofstream file {"/dev/null", std::ios::binary};
+    Window win;
+    win.style_base = base;
+    win.size = {20, 6};
+    win.winch();
+    win.render_file(file, true);
+    TEST_CHECK(win.buf_prev.size() == win.size);
+    TEST_CHECK(filled(win.buf, blank));
+
+    win.buf.put(Pos{2, 1}, "hello", ink);
+    auto const* drawn = win.buf.data();
+    auto const* spare = win.buf_prev.data();
+    win.render_file(file, true);
+    TEST_CHECK(win.buf_prev.data() == drawn);
+    TEST_CHECK(win.buf.data() == spare);
+    TEST_CHECK(win.buf_prev.col(Pos{2, 1}).text == Glyph("h"));
+    TEST_CHECK(win.buf_prev.col(Pos{6, 1}).text == Glyph("o"));
+    TEST_CHECK(filled(win.buf, blank));
+
+    // and back again on the next frame
+    win.render_file(file, true);
+    TEST_CHECK(win.buf_prev.data() == spare);
+    TEST_CHECK(win.buf.data() == drawn);
+    TEST_CHECK(filled(win.buf_prev, blank));
+    TEST_CHECK(filled(win.buf, blank));
+  }
+
+  {
+    // a frame goes out in one write, between the synchronized output markers
+    // when sync is set, and a frame with no changes writes nothing
+    std::string const begin {"\x1b[?2026h"};
+    std::string const end {"\x1b[?2026l"};
+    int fds[2];
+    TEST_CHECK(::pipe(fds) == 0);
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    auto const out = ::dup(STDOUT_FILENO);
+    ::dup2(fds[1], STDOUT_FILENO);
+
+    Window win;
+    win.style_base = base;
+    win.sync = true;
+    win.size = {20, 6};
+    win.winch();
+    win.render();
+    auto str = pending(fds[0]);
+    TEST_CHECK(starts(str, begin) && ends(str, end));
+    TEST_CHECK(win.wcount == 1);
+    TEST_CHECK(win.bsize == str.size());
+
+    win.buf.put(Pos{2, 1}, "hello", ink);
+    win.render();
+    str = pending(fds[0]);
+    TEST_CHECK(starts(str, begin) && ends(str, end));
+    TEST_CHECK(str.find("hello") != std::string::npos);
+    TEST_CHECK(win.wcount == 1);
+    TEST_CHECK(win.bsize == str.size());
+
+    // the text is erased, then nothing is left to change
+    win.render();
+    TEST_CHECK(!pending(fds[0]).empty());
+    win.render();
+    TEST_CHECK(pending(fds[0]).empty());
+    TEST_CHECK(win.wcount == 0);
+    TEST_CHECK(win.bsize == 0);
+
+    win.sync = false;
+    win.buf.put(Pos{2, 1}, "hello", ink);
+    win.render();
+    str = pending(fds[0]);
+    TEST_CHECK(!str.empty() && str.find(begin) == std::string::npos && str.find(end) == std::string::npos);
+    TEST_CHECK(win.wcount == 1);
+
+    ::dup2(out, STDOUT_FILENO);
+    ::close(out);
+    ::close(fds[0]);
+    ::close(fds[1]);
+  }
+
+  {
+    // frames handed to the presenter thread are either presented or replaced
+    // by a newer one, and the last one is what ends on the screen
+    int fds[2];
+    TEST_CHECK(::pipe(fds) == 0);
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    auto const out = ::dup(STDOUT_FILENO);
+    ::dup2(fds[1], STDOUT_FILENO);
+
+    constexpr std::size_t count {200};
+    Window win;
+    win.style_base = base;
+    win.threaded = true;
+    win.size = {20, 6};
+    win.winch();
+    std::string str;
+    for (std::size_t i = 1; i <= count; ++i) {
+      win.buf.put(Pos{2, 1}, std::to_string(i), ink);
+      win.render();
+      // the presenter writes blocking, keep the pipe from filling
+      str += pending(fds[0]);
+    }
+    auto const end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (win.queue.pending() && std::chrono::steady_clock::now() < end) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    win.present_stop();
+    str += pending(fds[0]);
+    TEST_CHECK(win.frames + win.dropped == count);
+    TEST_CHECK(win.buf_prev.col(Pos{2, 1}).text == Glyph("2"));
+    TEST_CHECK(win.buf_prev.col(Pos{3, 1}).text == Glyph("0"));
+    TEST_CHECK(win.buf_prev.col(Pos{4, 1}).text == Glyph("0"));
+    TEST_CHECK(str.find("200") != std::string::npos);
+
+    ::dup2(out, STDOUT_FILENO);
+    ::close(out);
+    ::close(fds[0]);
+    ::close(fds[1]);
+  }
+
+  {
+    // a row whose text moved left is shifted with delete character, fewer
+    // bytes than drawing it again, except when a wide glyph is on the row
+    struct Frame {
+      std::string stream;
+      std::size_t bsize;
+      std::size_t scrolled;
+    };
+    auto const moved = [&](bool const scroll, std::string_view const text) {
+      std::ofstream file {"window.ansi", std::ios::binary | std::ios::trunc};
+      Window win;
+      win.style_base = base;
+      win.scroll = scroll;
+      win.size = {40, 6};
+      win.winch();
+      win.buf.put(Pos{5, 2}, text, ink);
+      win.render_file(file, true);
+      file.close();
+      file.open("window.ansi", std::ios::binary | std::ios::trunc);
+      win.buf.put(Pos{3, 2}, text, ink);
+      win.render_file(file, true);
+      file.close();
+      std::ifstream in {"window.ansi", std::ios::binary};
+      std::string stream {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+      return Frame{stream, win.bsize.load(), win.scrolled.load()};
+    };
+
+    std::string_view const text {"the quick brown fox jumps over"};
+    auto const shifted = moved(true, text);
+    auto const drawn = moved(false, text);
+    TEST_CHECK(shifted.scrolled == 1);
+    TEST_CHECK(shifted.stream.find("\x1b[2P") != std::string::npos);
+    TEST_CHECK(shifted.bsize < drawn.bsize);
+    TEST_CHECK(drawn.scrolled == 0);
+
+    std::string_view const wide {"the quick brown 狐 jumps over"};
+    auto const kept = moved(true, wide);
+    TEST_CHECK(kept.scrolled == 0);
+    TEST_CHECK(kept.stream.find("P") == std::string::npos);
+  }
+
+  return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}